@@ -35,7 +35,7 @@ SHOPT RAWONLY=1				# make viraw the only vi mode
 SHOPT REGRESS=				# enable __regress__ builtin and instrumented intercepts for testing
 SHOPT REMOTE=				# enable --rc if running as a remote shell
 SHOPT SPAWN=				# use spawnveg for fork/exec
-SHOPT STATS=1				# add .sh.stats variable
+SHOPT STATS=1				# add .sh.stats variable and 'set -o profile'
 SHOPT SUID_EXEC=1			# allow (safe) SUID/SGID shell scripts
 SHOPT SYSRC=				# attempt . /etc/ksh.kshrc if interactive
 SHOPT TEST_L=				# add 'test -l' as an alias for 'test -L'
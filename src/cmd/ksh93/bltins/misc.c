@@ -149,7 +149,10 @@ int    b_exec(int argc,char *argv[], Shbltin_t *context)
 #endif /* JOBS */
 		/* if the main shell is about to be replaced, decrease SHLVL to cancel out a subsequent increase */
 		if(!sh.realsubshell)
+		{
 			(*SHLVL->nvalue.ip)--;
+			env_change();
+		}
 		/* force bad exec to terminate shell */
 		pp = (struct checkpt*)sh.jmplist;
 		pp->mode = SH_JMPEXIT;
@@ -314,6 +317,7 @@ int    b_dot_cmd(register int n,char *argv[],Shbltin_t *context)
 		else
 		{
 			buffer = sh_malloc(IOBSIZE+1);
+			fd = sh_pcopen(fd);
 			iop = sfnew(NIL(Sfio_t*),buffer,IOBSIZE,fd,SF_READ);
 			sh_offstate(SH_NOFORK);
 			sh_eval(iop,sh_isstate(SH_PROFILE)?SH_FUNEVAL:0);
@@ -340,7 +344,13 @@ int    b_dot_cmd(register int n,char *argv[],Shbltin_t *context)
 	sh.topscope = (Shscope_t*)prevscope;
 	nv_putval(SH_PATHNAMENOD, sh.st.filename ,NV_NOFREE);
 	if(jmpval && jmpval!=SH_JMPFUN)
+	{
+#if SHOPT_STATS
+		/* a POSIX function is not returned from */
+		sh_profleave(sh.fn_depth+sh.dot_depth);
+#endif /* SHOPT_STATS */
 		siglongjmp(*sh.jmplist,jmpval);
+	}
 	return(sh.exitval);
 }
 
@@ -401,9 +411,24 @@ int    b_shift(register int n, register char *argv[], Shbltin_t *context)
 
 int    b_wait(int n,register char *argv[],Shbltin_t *context)
 {
+	double sec;
+	char *last;
+	long timeout = 0;
 	NOT_USED(context);
 	while((n = optget(argv,sh_optwait))) switch(n)
 	{
+		case 't':
+			sec = strtod(opt_info.arg, &last);
+			if(last==opt_info.arg || *last || !(sec >= 0))
+			{
+				errormsg(SH_DICT,ERROR_exit(2),e_number,opt_info.arg);
+				UNREACHABLE();
+			}
+			if(sec >= INT_MAX)	/* practically forever */
+				timeout = 0;
+			else if(!(timeout = 1000*sec))
+				timeout = 1;
+			break;
 		case ':':
 			errormsg(SH_DICT,2, "%s", opt_info.arg);
 			break;
@@ -417,7 +442,7 @@ int    b_wait(int n,register char *argv[],Shbltin_t *context)
 		UNREACHABLE();
 	}
 	argv += opt_info.index;
-	job_bwait(argv);
+	job_bwait(argv,timeout);
 	return(sh.exitval);
 }
 
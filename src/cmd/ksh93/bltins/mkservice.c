@@ -23,6 +23,9 @@
  */
 
 #include	"shopt.h"
+#ifndef SH_DICT
+#   define SH_DICT	"libshell"
+#endif
 #include	"defs.h"
 
 #if !SHOPT_MKSERVICE
@@ -95,6 +98,12 @@ static const char eloop_usage[] =
 #include	<nval.h>
 #include	<sys/socket.h>
 #include 	<netinet/in.h>
+#include	"FEATURE/poll"
+
+#if _sys_epoll && _lib_epoll_create1
+#   include	<sys/epoll.h>
+#   define _use_epoll	1
+#endif
 
 #define ACCEPT	0
 #define ACTION	1
@@ -128,52 +137,135 @@ struct Service_s
 };
 
 static int		*file_list;
-static Sfio_t		**poll_list;
-static Service_t	**service_list;
+static Service_t	**service_list;	/* indexed by file descriptor */
+static int		nservice;	/* size of service_list and file_list */
 static int		npoll;
 static int		nready;
 static int		ready;
 static int		(*covered_fdnotify)(int, int);
 
-static int fdclose(Service_t *sp, register int fd)
+#if _use_epoll
+/*
+ * The service and connection file descriptors are kept in an epoll(7)
+ * interest set, so that waiting costs the same for any number of idle
+ * connections and only the ready ones are dispatched. This is level
+ * triggered because an action function need not read all pending data.
+ */
+static int			epfd = -1;
+static pid_t			eppid;		/* process that owns epfd */
+static struct epoll_event	evlist[64];
+
+static void evinit(void);
+
+static void evadd(int fd)
+{
+	struct epoll_event ev;
+	if(eppid != sh.current_pid)
+		evinit();
+	ev.events = EPOLLIN;
+	ev.data.fd = fd;
+	epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static void evdel(int fd)
+{
+	struct epoll_event ev;
+	if(eppid != sh.current_pid)
+		evinit();
+	epoll_ctl(epfd, EPOLL_CTL_DEL, fd, &ev);
+}
+
+/*
+ * the interest set is shared across fork(2), so a forked child, e.g. of a
+ * virtual subshell, must create its own before changing it
+ */
+static void evinit(void)
 {
 	register int i;
-	service_list[fd] = 0;
-	if(sp->fd==fd)
-		sp->fd = -1;
+	if(epfd >= 0)
+		close(epfd);
+	epfd = epoll_create1(EPOLL_CLOEXEC);
+	eppid = sh.current_pid;
+	for(i=0; i < npoll; i++)
+		evadd(file_list[i]);
+}
+#else
+static Sfio_t		**poll_list;
+#   define evadd(fd)
+#   define evdel(fd)
+#endif /* _use_epoll */
+
+#define getservice(fd)	((fd)>=0 && (fd)<nservice ? service_list[fd] : 0)
+
+static void setservice(int fd, Service_t *sp)
+{
+	if(fd >= nservice)
+	{
+		int n = nservice;
+		if(!sp)
+			return;
+		nservice = roundof(fd+1,32);
+		file_list = sh_newof(file_list,int,nservice,0);
+		service_list = sh_newof(service_list,Service_t*,nservice,0);
+		memset((void*)&service_list[n],0,(nservice-n)*sizeof(Service_t*));
+#if !_use_epoll
+		poll_list = sh_newof(poll_list,Sfio_t*,nservice+1,0);
+#endif /* !_use_epoll */
+	}
+	service_list[fd] = sp;
+}
+
+static int fdremove(register int fd)
+{
+	register int i;
+	setservice(fd,0);
 	for(i=0; i < npoll; i++)
 	{
 		if(file_list[i]==fd)
 		{
-			file_list[i] = file_list[npoll--];
-			if(sp->actionf)
-				(*sp->actionf)(sp, fd, 1);
+			file_list[i] = file_list[--npoll];
+			evdel(fd);
 			return(1);
 		}
 	}
 	return(0);
 }
 
+static int fdclose(Service_t *sp, register int fd)
+{
+	if(sp->fd==fd)
+		sp->fd = -1;
+	if(!fdremove(fd))
+		return(0);
+	if(sp->actionf)
+		(*sp->actionf)(sp, fd, 1);
+	return(1);
+}
+
 static int fdnotify(int fd1, int fd2)
 {
 	Service_t *sp;
 	if (covered_fdnotify)
 		(*covered_fdnotify)(fd1, fd2);
+	if(!(sp = getservice(fd1)))
+		return(0);
 	if(fd2!=SH_FDCLOSE)
 	{
 		register int i;
-		service_list[fd2] = service_list[fd1];
-		service_list[fd1] = 0;
+		setservice(fd2,sp);
+		setservice(fd1,0);
 		for(i=0; i < npoll; i++)
 		{
 			if(file_list[i]==fd1)
 			{
 				file_list[i] = fd2;
+				evdel(fd1);
+				evadd(fd2);
 				return(0);
 			}
 		}
 	}
-	else if(sp = service_list[fd1])
+	else
 	{
 		fdclose(sp,fd1);
 		if(--sp->refcount==0)
@@ -182,51 +274,120 @@ static int fdnotify(int fd1, int fd2)
 	return(0);
 }
 
-static void process_stream(Sfio_t* iop)
+static void process_stream(int fd)
 {
-	int r=0, fd = sffileno(iop);
-	Service_t * sp = service_list[fd];
+	int r=0;
+	Service_t * sp = getservice(fd);
+	if(!sp)		/* closed by an earlier action */
+		return;
 	if(fd==sp->fd)	/* connection socket */
 	{
 		struct sockaddr addr;
 		socklen_t addrlen = sizeof(addr);
-		fd = accept(fd, &addr, &addrlen);
-		service_list[fd] = sp;
-		sp->refcount++;
-		file_list[npoll++] = fd;
-		if(fd>=0)
+		if((fd = accept(fd, &addr, &addrlen)) >= 0 && sp->acceptf)
+			fd = (*sp->acceptf)(sp,fd);
+		if(fd >= 0)
 		{
-			if(sp->acceptf)
-				r = (*sp->acceptf)(sp,fd);
+			setservice(fd,sp);
+			sp->refcount++;
+			file_list[npoll++] = fd;
+			evadd(fd);
 		}
 	}
 	else if(sp->actionf)
 	{
-		service_list[fd] = 0;
+		setservice(fd,0);
 		r = (*sp->actionf)(sp, fd, 0);
-		service_list[fd] = sp;
+		setservice(fd,sp);
 		if(r<0)
-			close(fd);
+		{
+			fdclose(sp,fd);
+			sh_close(fd);
+			if(--sp->refcount==0)
+				nv_unset(sp->node);
+		}
+	}
+}
+
+#if _use_epoll
+static int waitnotify(int fd, long timeout, int rw)
+{
+	Sfio_t	*special=0;
+	int	added, err;
+	register int	i;
+
+	NOT_USED(rw);
+	if (fd >= 0)
+		special = sh_fd2sfio(fd);
+	if (eppid != sh.current_pid)
+		evinit();
+	while(1)
+	{
+		while(ready < nready)
+			process_stream(evlist[ready++].data.fd);
+		nready = ready = 0;
+		added = 0;
+		if(special)
+		{
+			/* input may already be buffered */
+			if(sfpoll(&special,1,0) > 0)
+				return(fd);
+			if(!getservice(fd))
+			{
+				struct epoll_event ev;
+				ev.events = EPOLLIN;
+				ev.data.fd = fd;
+				if(epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+					return(fd);	/* not pollable, e.g. a regular file */
+				added = 1;
+			}
+		}
+		errno = 0;
+		nready = epoll_wait(epfd, evlist, elementsof(evlist), timeout);
+		err = errno;
+		if(added)
+			evdel(fd);
+		if(nready<=0)
+		{
+			nready = 0;
+			return((errno=err)? -1: 0);
+		}
+		if(special)
+		{
+			for(i=0; i < nready; i++)
+			{
+				if(evlist[i].data.fd==fd)
+				{
+					/* the other ready descriptors are dispatched on the next call */
+					evlist[i] = evlist[0];
+					ready = 1;
+					return(fd);
+				}
+			}
+		}
 	}
 }
-				
+#else
 static int waitnotify(int fd, long timeout, int rw)
 {
 	Sfio_t *special=0, **pstream;
 	register int	i;
 
+	NOT_USED(rw);
 	if (fd >= 0)
 		special = sh_fd2sfio(fd);
 	while(1)
 	{
-		pstream = poll_list;
 		while(ready < nready)
-			process_stream(pstream[ready++]);
+			process_stream(sffileno(poll_list[ready++]));
+		if(!poll_list)
+			poll_list = sh_newof(NULL,Sfio_t*,nservice+1,0);
+		pstream = poll_list;
 		if(special)
 			*pstream++ = special;
 		for(i=0; i < npoll; i++)
 		{
-			if(service_list[file_list[i]])
+			if(getservice(file_list[i]))
 				*pstream++ = sh_fd2sfio(file_list[i]);
 		}
 		for(i=0; i < pstream-poll_list; i++)
@@ -257,13 +418,13 @@ static int waitnotify(int fd, long timeout, int rw)
 		}
 	}
 }
+#endif /* _use_epoll */
 
 static int service_init(void)
 {
-	int n = 20;
-	file_list = (int*)sh_newof(NULL,short,n,0);
-	poll_list = sh_newof(NULL,Sfio_t*,n,0);
-	service_list = sh_newof(NULL,Service_t*,n,0);
+#if _use_epoll
+	evinit();
+#endif /* _use_epoll */
 	covered_fdnotify = sh_fdnotify(fdnotify);
 	sh_waitnotify(waitnotify);
 	return(1);
@@ -274,8 +435,9 @@ void service_add(Service_t *sp)
 	static int init;
 	if (!init)
 		init = service_init();
-	service_list[sp->fd] = sp;
+	setservice(sp->fd,sp);
 	file_list[npoll++] = sp->fd;
+	evadd(sp->fd);
 }
 
 static int Accept(register Service_t *sp, int accept_fd)
@@ -283,10 +445,10 @@ static int Accept(register Service_t *sp, int accept_fd)
 	register Namval_t*	nq = sp->disc[ACCEPT];
 	int			fd;
 
-	fd = fcntl(accept_fd, F_DUPFD, 10);
+	fd = sh_fcntl(accept_fd, F_DUPFD, 10);
+	sh_close(accept_fd);
 	if (fd >= 0)
 	{
-		close(accept_fd);
 		if (nq)
 		{
 			char*	av[3];
@@ -297,7 +459,7 @@ static int Accept(register Service_t *sp, int accept_fd)
 			sfsprintf(buff, sizeof(buff), "%d", fd);
 			if (sh_fun(nq, sp->node, av))
 			{
-				close(fd);
+				sh_close(fd);
 				return -1;
 			}
 		}
@@ -380,11 +542,12 @@ static void putval(Namval_t* np, const char* val, int flag, Namfun_t* fp)
 	if (!val)
 	{
 		register int i;
-		for(i=0; i< sh.lim.open_max; i++)
+		for(i=0; i < nservice; i++)
 		{
 			if(service_list[i]==sp)
 			{
-				close(i);
+				fdremove(i);
+				sh_close(i);
 				if(--sp->refcount<=0)
 					break;
 			}
@@ -447,8 +610,8 @@ int	b_mkservice(int argc, char** argv, Shbltin_t *context)
 		error(ERROR_exit(1), "%s: cannot start service", path);
 		UNREACHABLE();
 	}
-	if((sp->fd = fcntl(fd, F_DUPFD, 10))>=10)
-		close(fd);
+	if((sp->fd = sh_fcntl(fd, F_DUPFD, 10))>=10)
+		sh_close(fd);
 	else
 		sp->fd = fd;
 	np = nv_open(var,sh.var_tree,NV_ARRAY|NV_VARNAME);
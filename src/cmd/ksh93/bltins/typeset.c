@@ -63,6 +63,7 @@ struct tdata
 	char		*help;
 	short     	aflag;
 	short     	pflag;
+	short		hflag;
 	int     	argnum;
 	int     	scanmask;
 	Dt_t 		*scanroot;
@@ -275,6 +276,10 @@ int    b_typeset(int argc,register char *argv[],Shbltin_t *context)
 			case 'A':
 				flag |= NV_ARRAY;
 				break;
+			case 'U':
+				flag |= NV_ARRAY;
+				tdata.hflag = 1;
+				break;
 			case 'C':
 				flag |= NV_COMVAR;
 				break;
@@ -865,7 +870,7 @@ static int     setall(char **argv,register int flag,Dt_t *troot,struct tdata *tp
 							nv_onattr(np,NV_NOFREE);
 						}
 					}
-					nv_setarray(np,nv_associative);
+					nv_setarray(np,tp->hflag?nv_hashassoc:nv_associative);
 				}
 				else if(comvar && !nv_isvtree(np) && !nv_rename(np,flag|NV_COMVAR))
 					nv_setvtree(np);
@@ -51,7 +51,7 @@ static int whence(char**, int);
  */
 int	b_command(register int argc,char *argv[],Shbltin_t *context)
 {
-	register int n, flags=0;
+	register int n, flags=0, jobs=1;
 	opt_info.index = opt_info.offset = 0;
 	while((n = optget(argv,sh_optcommand))) switch(n)
 	{
@@ -72,6 +72,15 @@ int	b_command(register int argc,char *argv[],Shbltin_t *context)
 	    case 'x':
 		flags |= P_FLAG;
 		break;
+	    case 'P':
+		if((jobs = (int)opt_info.num) < 1)
+		{
+			if(argc==0)
+				return(0);
+			errormsg(SH_DICT,ERROR_exit(1),e_number,opt_info.arg);
+			UNREACHABLE();
+		}
+		break;
 	    case ':':
 		if(argc==0)
 			return(0);
@@ -88,10 +97,20 @@ int	b_command(register int argc,char *argv[],Shbltin_t *context)
 	{
 		if((flags & (X_FLAG|V_FLAG)) || !*argv)
 			return(0);	/* return no offset now; sh_exec() will treat command -v/-V/(null) as normal builtin */
+		if(jobs > 1 && !(flags & P_FLAG))
+			return(0);	/* -P without -x: let the error below be reported */
 		if(flags & P_FLAG)
+		{
 			sh_onstate(SH_XARG);
+			sh.xargjobs = jobs;
+		}
 		return(opt_info.index); /* offset for sh_exec() to remove 'command' prefix + options */
 	}
+	if(jobs > 1 && !(flags & (P_FLAG|X_FLAG|V_FLAG)))
+	{
+		errormsg(SH_DICT,2,"-P requires -x");
+		error_info.errors++;
+	}
 	if(error_info.errors)
 	{
 		errormsg(SH_DICT,ERROR_usage(2),"%s", optusage((char*)0));
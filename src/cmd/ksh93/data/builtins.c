@@ -305,6 +305,12 @@ const char sh_set[] =
 			"be zero if all commands return zero exit status.]"
 		"[+posix?Enable full POSIX standard compliance mode.]"
 		"[+privileged?Equivalent to \b-p\b.]"
+#if SHOPT_STATS
+		"[+profile?Measure the time, processes and memory allocations "
+			"used by each command and function and write a report "
+			"on exit to the file named by \bKSH_PROFILE\b or to "
+			"standard error.]"
+#endif
 		"[+showme?Simple commands preceded by a \b;\b will be traced "
 			"as if \b-x\b were enabled but not executed.]"
 		"[+trackall?Equivalent to \b-h\b.]"
@@ -551,7 +557,7 @@ const char sh_optcd[] =
 ;
 
 const char sh_optcommand[] =
-"[-1c?\n@(#)$Id: command (ksh 93u+m) 2021-01-30 $\n]"
+"[-1c?\n@(#)$Id: command (ksh 93u+m) 2022-11-01 $\n]"
 "[--catalog?" SH_DICT "]"
 "[+NAME?command - execute a simple command disabling special properties]"
 "[+DESCRIPTION?Without \b-v\b or \b-V\b,  \bcommand\b executes \acmd\a "
@@ -583,6 +589,10 @@ const char sh_optcommand[] =
 	"are considered static and will be repeated for each invocation "
 	"so as to allow all invocations to use the same command options. "
 	"The exit status will be the highest returned by the invocations.]"
+"[P]#[jobs?With \b-x\b, run up to \ajobs\a invocations of \acmd\a "
+	"at the same time, dividing the \aarg\as over at least \ajobs\a "
+	"invocations even if they would fit in one. A new invocation is "
+	"started as soon as a running one completes. The default is \b1\b.]"
 "\n"
 "\n[cmd [arg ...]]\n"
 "\n"
@@ -1829,7 +1839,7 @@ const char sh_opttrap[] =
 ;
 
 const char sh_opttypeset[] =
-"+[-1c?\n@(#)$Id: typeset (ksh 93u+m) 2022-06-01 $\n]"
+"+[-1c?\n@(#)$Id: typeset (ksh 93u+m) 2022-11-01 $\n]"
 "[--catalog?" SH_DICT "]"
 "[+NAME?typeset - declare or display variables with attributes]"
 "[+DESCRIPTION?Without the \b-f\b option, \btypeset\b sets, unsets, "
@@ -1945,6 +1955,11 @@ const char sh_opttypeset[] =
 	"will have function static scope.  Otherwise, the variable is "
 	"unset prior to processing the assignment list.]"
 "[T]:?[tname?\atname\a is the name of a type name given to each \aname\a.]"
+"[U?Unordered associative array.  Like \b-A\b, but the subscripts of a "
+	"newly created or existing associative array are kept in a hash table "
+	"instead of in sorted order.  This makes adding and looking up elements "
+	"faster for large arrays, but subscripts are listed in no particular "
+	"order.]"
 "[Z]#?[n?Zero fill.  If \an\a is given it represents the field width.]"
 "\n"
 "\n[name[=value]...]\n"
@@ -2085,7 +2100,7 @@ const char sh_optunalias[] =
 ;
 
 const char sh_optwait[]	=
-"[-1c?\n@(#)$Id: wait (AT&T Research) 1999-06-17 $\n]"
+"[-1c?\n@(#)$Id: wait (ksh 93u+m) 2022-11-01 $\n]"
 "[--catalog?" SH_DICT "]"
 "[+NAME?wait - wait for process or job completion]"
 "[+DESCRIPTION?\bwait\b with no operands, waits until all jobs "
@@ -2096,6 +2111,9 @@ _JOB_
 "[+?If one or more \ajob\a operands is a process ID or process group ID "
 	"not known by the current shell environment, \bwait\b treats each "
 	"of them as if it were a process that exited with status 127.]"
+"[t]:[timeout?Stop waiting when \atimeout\a seconds have passed and not "
+	"all of the jobs have terminated. \atimeout\a may be a fraction. "
+	"Jobs that are still running are not affected.]"
 "\n"
 "\n[job ...]\n"
 "\n"
@@ -2107,6 +2125,8 @@ _JOB_
 		"processes known by the invoking process have terminated.]"
 	"[+127?\ajob\a is a process ID or process group ID that is unknown "
 		"to the current shell environment.]"
+	"[+>128?The \b-t\b \atimeout\a expired. The exit status is 128 plus "
+		"the number of the \bALRM\b signal.]"
 "}"
 
 "[+SEE ALSO?\bjobs\b(1), \bps\b(1)]"
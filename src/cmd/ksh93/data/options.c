@@ -75,6 +75,9 @@ const Shtable_t shtab_options[] =
 	"pipefail",			SH_PIPEFAIL,
 	"posix",			SH_POSIX,
 	"privileged",			SH_PRIVILEGED,
+#if SHOPT_STATS
+	"profile",			SH_PROFILING,
+#endif
 	"rc",				SH_RC|SH_COMMANDLINE,
 	"restricted",			SH_RESTRICTED,
 	"showme",			SH_SHOWME,
@@ -97,6 +100,7 @@ const Shtable_t shtab_attributes[] =
 	{"-rreadonly",	NV_RDONLY},
 	{"-ttagged",	NV_TAGGED},
 	{"-Aassociative array",	NV_ARRAY},
+	{"-Uunordered associative array",	NV_ARRAY},
 	{"-aindexed array",	NV_ARRAY},
 	{"-llong",	(NV_DOUBLE|NV_LONG)},
 	{"-Eexponential",(NV_DOUBLE|NV_EXPNOTE)},
@@ -65,6 +65,7 @@
 	int	histmask;	/* power of two mask for histcnt */ \
 	char	histbuff[HIST_BSIZE+1];	/* history file buffer */ \
 	int	histwfail; \
+	struct Histidx *histidx;	/* search index, see hist_idxsync() */ \
 	_HIST_AUDIT \
 	off_t	histcmds[2];	/* offset for recent commands, must be last */
 
@@ -94,6 +95,26 @@ static int	hist_check(int);
 static int	hist_clean(int);
 static ssize_t	hist_write(Sfio_t*, const void*, size_t, Sfdisc_t*);
 static int	hist_exceptf(Sfio_t*, int, void*, Sfdisc_t*);
+static void	hist_idxfree(History_t*);
+
+/*
+ * In-memory index for history searches. The history file is only ever
+ * appended to, so a copy of its text stays valid while other shells add
+ * commands to it; hist_idxsync() extends the copy to the current end of
+ * the history list before each search and starts over if the file shrank.
+ * Each command also gets a signature with one bit set for every trigram
+ * (sequence of three bytes) in it, so that hist_find() can skip commands
+ * that lack a trigram of the search string without looking at their text.
+ */
+struct Histidx
+{
+	char		*text;		/* copy of history file text */
+	off_t		base;		/* file offset of text[0] */
+	off_t		end;		/* file offset just past copied text */
+	size_t		size;		/* allocated size of text */
+	off_t		*sigoff;	/* command offset that each sig[] is for */
+	Sfulong_t	*sig;		/* trigram signatures, indexed like histcmds */
+};
 
 static int	histinit;
 static mode_t	histmode;
@@ -274,6 +295,7 @@ retry:
 	sh.hist_ptr = hist_ptr = hp;
 	hp->histsize = maxlines;
 	hp->histmask = histmask;
+	hp->histidx = 0;
 	hp->histfp= sfnew(NIL(Sfio_t*),hp->histbuff,HIST_BSIZE,fd,SF_READ|SF_WRITE|SF_APPENDWR|SF_SHARE);
 	memset((char*)hp->histcmds,0,sizeof(off_t)*(hp->histmask+1));
 	hp->histind = 1;
@@ -367,6 +389,7 @@ retry:
 void hist_close(register History_t *hp)
 {
 	sfclose(hp->histfp);
+	hist_idxfree(hp);
 #if SHOPT_AUDIT
 	if(hp->auditfp)
 	{
@@ -503,6 +526,7 @@ static History_t* hist_trim(History_t *hp, int n)
 		unlink(tmpname);
 		free(tmpname);
 	}
+	hist_idxfree(hist_old);
 	free((char*)hist_old);
 	return hist_ptr = hist_new;
 }
@@ -585,6 +609,7 @@ void hist_eof(register History_t *hp)
 	off_t last = sfseek(hp->histfp,(off_t)0,SEEK_END);
 	if(last < count)
 	{
+		hist_idxfree(hp);
 		last = -1;
 		count = 2+HIST_MARKSZ;
 		oldind = hp->histind;
@@ -880,6 +905,112 @@ void hist_list(register History_t *hp,Sfio_t *outfile, off_t offset,int last, ch
 	return;
 }
 
+/*
+ * free the search index
+ */
+static void hist_idxfree(History_t *hp)
+{
+	register struct Histidx *ip = hp->histidx;
+	if(!ip)
+		return;
+	free((void*)ip->text);
+	free((void*)ip->sigoff);
+	free((void*)ip->sig);
+	free((void*)ip);
+	hp->histidx = 0;
+}
+
+/*
+ * bring the search index up to date with the history list
+ * returns 0 if there is no index
+ */
+static struct Histidx *hist_idxsync(History_t *hp)
+{
+	register struct Histidx *ip = hp->histidx;
+	off_t base, end = hp->histcnt;
+	ssize_t r;
+	int n = hist_min(hp);
+	while(n < hist_max(hp) && hist_tell(hp,n) < 2)
+		n++;
+	if((base = hist_tell(hp,n)) < 2 || base > end)
+		return(0);
+	if(!ip)
+	{
+		ip = sh_newof(0,struct Histidx,1,0);
+		ip->sigoff = sh_newof(0,off_t,hp->histmask+1,0);
+		ip->sig = sh_newof(0,Sfulong_t,hp->histmask+1,0);
+		ip->base = ip->end = base;
+		hp->histidx = ip;
+	}
+	else if(base < ip->base || end < ip->end)
+	{
+		/* history file was rewritten; start over */
+		memset((void*)ip->sigoff,0,(hp->histmask+1)*sizeof(off_t));
+		ip->base = ip->end = base;
+	}
+	else if(base >= ip->end)
+		ip->base = ip->end = base;
+	else if(base-ip->base > (ip->end-ip->base)/2)
+	{
+		/* discard text of commands that are no longer accessible */
+		memmove(ip->text,ip->text+(base-ip->base),ip->end-base);
+		ip->base = base;
+	}
+	if(end > ip->end)
+	{
+		size_t size = end-ip->base+1;
+		if(size > ip->size)
+		{
+			ip->size = size+size/2+HIST_BSIZE;
+			ip->text = sh_newof(ip->text,char,ip->size,0);
+		}
+		if(sfseek(hp->histfp,ip->end,SEEK_SET)==ip->end && (r=sfread(hp->histfp,ip->text+(ip->end-ip->base),end-ip->end)) > 0)
+			ip->end += r;
+	}
+	if(!ip->text)
+		return(0);
+	ip->text[ip->end-ip->base] = 0;
+	return(ip);
+}
+
+/*
+ * compute the trigram signature of the <n> bytes at <cp>
+ */
+static Sfulong_t hist_sig(register const unsigned char *cp, register int n)
+{
+	register Sfulong_t sig = 0;
+	register unsigned int h;
+	for(; n >= 3; n--, cp++)
+	{
+		h = (cp[0]*31+cp[1])*31+cp[2];
+		sig |= (Sfulong_t)1 << ((h^(h>>6))&63);
+	}
+	return(sig);
+}
+
+/*
+ * return the trigram signature of command <index> at offset <offset>
+ * or all bits set if it is not in the index
+ */
+static Sfulong_t hist_cmdsig(History_t *hp, register struct Histidx *ip, int index, off_t offset)
+{
+	register int c = hist_ind(hp,index);
+	char *cp;
+	size_t n;
+	if(ip->sigoff[c]!=offset)
+	{
+		if(offset < ip->base || offset >= ip->end)
+			return(~(Sfulong_t)0);
+		cp = ip->text+(offset-ip->base);
+		/* the end of the command may not have been read yet */
+		if((n=strlen(cp)) >= ip->end-offset)
+			return(~(Sfulong_t)0);
+		ip->sig[c] = hist_sig((unsigned char*)cp,(int)n);
+		ip->sigoff[c] = offset;
+	}
+	return(ip->sig[c]);
+}
+
 /*
  * find index for last line with given string
  * If flag==0 then line must begin with string
@@ -890,6 +1021,8 @@ Histloc_t hist_find(register History_t*hp,char *string,register int index1,int f
 	register int index2;
 	off_t offset;
 	int *coffset=0;
+	Sfulong_t sig=0;
+	struct Histidx *ip;
 	Histloc_t location;
 	location.hist_command = -1;
 	location.hist_char = 0;
@@ -921,10 +1054,14 @@ Histloc_t hist_find(register History_t*hp,char *string,register int index1,int f
 	}
 	else if(index1 >= index2)
 		return(location);
+	if(ip = hist_idxsync(hp))
+		sig = hist_sig((unsigned char*)string,(int)strlen(string));
 	while(index1!=index2)
 	{
 		direction>0?++index1:--index1;
 		offset = hist_tell(hp,index1);
+		if(sig && (hist_cmdsig(hp,ip,index1,offset)&sig)!=sig)
+			continue;
 		if((location.hist_line=hist_match(hp,offset,string,coffset))>=0)
 		{
 			location.hist_command = index1;
@@ -946,11 +1083,22 @@ int hist_match(register History_t *hp,off_t offset,char *string,int *coffset)
 {
 	register unsigned char *first, *cp;
 	register int m,n,c=1,line=0;
+	register struct Histidx *ip = hp->histidx;
 	mbinit();
-	sfseek(hp->histfp,offset,SEEK_SET);
-	if(!(cp = first = (unsigned char*)sfgetr(hp->histfp,0,0)))
-		return(-1);
-	m = sfvalue(hp->histfp);
+	m = 0;
+	if(ip && offset >= ip->base && offset < ip->end)
+	{
+		cp = first = (unsigned char*)ip->text+(offset-ip->base);
+		if((m = (int)strlen((char*)cp)+1) > ip->end-offset)
+			m = 0;	/* end of command not yet in index */
+	}
+	if(!m)
+	{
+		sfseek(hp->histfp,offset,SEEK_SET);
+		if(!(cp = first = (unsigned char*)sfgetr(hp->histfp,0,0)))
+			return(-1);
+		m = sfvalue(hp->histfp);
+	}
 	n = (int)strlen(string);
 	while(m > n)
 	{
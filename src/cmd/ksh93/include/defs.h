@@ -121,6 +121,7 @@ extern char 		**sh_envgen(void);
 extern void 		sh_envnolocal(Namval_t*,void*);
 extern Sfdouble_t	sh_arith(const char*);
 extern void		*sh_arithcomp(char*);
+extern void		*sh_arithdol(const char*,const char*,int*);
 extern pid_t 		sh_fork(int,int*);
 extern pid_t		_sh_fork(pid_t, int ,int*);
 extern void		sh_invalidate_ifs(void);
@@ -223,8 +224,16 @@ extern const char	e_dot[];	/* default path & name of dot command: "." */
 #   define	STAT_SUBSHELL	13
     extern const Shtable_t shtab_stats[];
 #   define sh_stats(x)	(sh.stats[(x)]++)
+    /* per-command profiler, see profile.c */
+    extern void		sh_profcmd(int);
+    extern int		sh_profenter(const char*);
+    extern void		sh_profleave(int);
+    extern void		sh_profchild(void);
+    extern void		sh_profend(void);
+#   define sh_profile(n)	(sh_isoption(SH_PROFILING)?sh_profcmd(n):(void)0)
 #else
 #   define sh_stats(x)
+#   define sh_profile(n)
 #endif /* SHOPT_STATS */
 
 #endif /* !defs_h_defined */
@@ -58,6 +58,7 @@ struct process
 {
 	struct process *p_nxtjob;	/* next job structure */
 	struct process *p_nxtproc;	/* next process in current job */
+	struct process *p_nxtpid;	/* next process in PID hash chain */
 	int		*p_exitval;	/* place to store the exitval */
 	pid_t		p_pid;		/* process ID */
 	pid_t		p_pgrp;		/* process group */
@@ -158,10 +159,11 @@ extern const char	e_signo[];
  */
 
 extern void	job_clear(void);
-extern void	job_bwait(char**);
+extern void	job_bwait(char**,long);
 extern int	job_walk(Sfio_t*,int(*)(struct process*,int),int,char*[]);
 extern int	job_kill(struct process*,int);
 extern int	job_wait(pid_t);
+extern int	job_waitany(pid_t*,int);
 extern int	job_post(pid_t,pid_t);
 extern void	*job_subsave(void);
 extern void	job_subrestore(void*);
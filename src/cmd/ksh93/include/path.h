@@ -58,6 +58,7 @@ typedef struct pathcomp
 	char		*lib;
 	char		*bbuf;
 	char		*blib;
+	struct pathdir	*dir;		/* snapshot of directory contents */
 	unsigned short	len;
 	unsigned short	flags;
 } Pathcomp_t;
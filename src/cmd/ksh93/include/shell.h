@@ -146,6 +146,9 @@ typedef union Shnode_u Shnode_t;
 #define SH_MULTILINE	47
 #define SH_NOBACKSLCTRL	48
 #endif
+#if SHOPT_STATS
+#define SH_PROFILING	49
+#endif
 #define SH_LOGIN_SHELL	67
 #define SH_NOUSRPROFILE	79	/* internal use only */
 #define SH_COMMANDLINE	0x100	/* bit flag for invocation-only options ('set -o' cannot change them) */
@@ -328,8 +331,10 @@ struct Shell_s
 	char		redir0;		/* redirect of 0 */
 	char		intrace;	/* set when trace expands PS4 */
 	char		*readscript;	/* set before reading a script */
+	void		*pcache;	/* parse cache file for next sh_eval(), see pcache.c */
 	int		*inpipe;	/* input pipe pointer */
 	int		*outpipe;	/* output pipe pointer */
+	int		*spawnfds;	/* file descriptor operations for next spawn, see spawnvefd(3) */
 	int		cpipe[3];
 	int		coutpipe;
 	int		inuse_bits;
@@ -342,6 +347,7 @@ struct Shell_s
 	int		xargmin;
 	int		xargmax;
 	int		xargexit;
+	int		xargjobs;	/* command -x -P: parallel invocations */
 	int		nenv;
 	mode_t		mask;
 	void		*init_context;
@@ -390,6 +396,10 @@ struct Shell_s
 #if SHOPT_REGRESS
 	struct Regress_s *regress;
 #endif /* SHOPT_REGRESS */
+#if SHOPT_STATS
+	void		*profile;	/* data for 'set -o profile', see profile.c */
+	unsigned long	nalloc;		/* number of sh_*alloc() calls */
+#endif /* SHOPT_STATS */
 };
 
 /* used for builtins */
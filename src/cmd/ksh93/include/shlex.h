@@ -38,7 +38,7 @@ struct _shlex_pvt_lexstate_
 	char		testop1;	/* 1 when unary test op legal */
 	char		testop2;	/* 1 when binary test op legal */
 	char		reservok;	/* >0 for reserved word legal */
-	char		skipword;	/* next word can't be reserved */
+	char		skipword;	/* next word can't be reserved; 2 after for, 3 after for -P */
 	char		last_quote;	/* last multi-line quote character */
 	char		nestedbrace;	/* ${var op {...}} */
 };
@@ -83,6 +83,8 @@ typedef struct  _shlex_
 	char		comp_assign;	/* in compound assignment */
 	char		comsub;		/* parsing command substitution */
 	char		noreserv;	/* reserved works not legal */
+	char		aliased;	/* set when a user-defined alias was expanded */
+	char		dcltype;	/* set when a user-defined declaration command was used */
 	int		inlineno;	/* saved value of sh.inlineno */
 	int		firstline;	/* saved value of sh.st.firstline */
 	int		assignlevel;	/* nesting level for assignment */
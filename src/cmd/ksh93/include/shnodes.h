@@ -38,6 +38,8 @@
 #define FALTPIPE	(02000<<COMBITS)	/* alternate pipes &| */
 #define FPOSIX		(02<<COMBITS)		/* POSIX semantics function */
 #define FLINENO		(04<<COMBITS)		/* for/case has line number */
+#define FPARFOR		(010<<COMBITS)		/* for -P: parallel loop */
+#define FKEEP		(020<<COMBITS)		/* for -P -k: keep output order */
 #define FOPTGET		(0200<<COMBITS)		/* function calls getopts */
 
 #define TNEGATE		(01<<COMBITS)		/* ! inside [[ ... ]] */
@@ -108,6 +110,7 @@ struct fornod
 	Shnode_t	*fortre;
 	struct comnod	*forlst;
 	int		forline;
+	struct argnod	*forpar;	/* number of parallel jobs for -P */
 };
 
 struct swnod
@@ -210,5 +213,8 @@ extern void			sh_funstaks(struct slnod*,int);
 extern Sfio_t 			*sh_subshell(Shnode_t*, volatile int, int);
 extern int			sh_tdump(Sfio_t*, const Shnode_t*);
 extern Shnode_t			*sh_trestore(Sfio_t*);
+extern int			sh_pcopen(int);
+extern int			sh_pcdump(void*, const Shnode_t*);
+extern void			sh_pcclose(void*, int);
 
 #endif /* _SHNODES_H */
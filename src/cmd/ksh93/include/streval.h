@@ -80,6 +80,7 @@ struct lval
 	short		elen;
 	char		eflag;
 	char		isfloat;
+	char		isint;		/* value is an exact Sflong_t */
 };
 
 struct mathtab
@@ -100,6 +101,7 @@ typedef struct _arith_
 } Arith_t;
 #define ARITH_COMP	04	/* set when compile separate from execute */
 #define ARITH_ASSIGNOP	010	/* set during assignment operators */
+#define ARITH_LATE	020	/* bind variable names at execution time */
 
 #define MAXPREC		15	/* maximum precision level */
 #define SEQPOINT	0200	/* sequence point */
@@ -56,6 +56,19 @@ static Namval_t FunNode =
 	"?",
 };
 
+#define ARITHCACHE	64	/* must be a power of 2 */
+
+/* compiled arithmetic expressions, see arith_cached() */
+static struct Arithcache
+{
+	Arith_t		*ep;
+	char		*expr;		/* copy of the expression, ep->expr */
+	unsigned int	hash;
+	int		len;
+	int		key;		/* options the compiled code depends on */
+} arithcache[ARITHCACHE];
+static char	nocache;	/* set if expression being compiled can't be cached */
+
 static Namval_t *scope(register Namval_t *np,register struct lval *lvalue,int assign)
 {
 	register int flag = lvalue->flag;
@@ -70,7 +83,16 @@ static Namval_t *scope(register Namval_t *np,register struct lval *lvalue,int as
 	if(nosub<0 && lvalue->ovalue)
 		return((Namval_t*)lvalue->ovalue);
 	lvalue->ovalue = 0;
-	if(cp>=lvalue->expr &&  cp < lvalue->expr+lvalue->elen)
+	if(cp>=lvalue->expr &&  cp < lvalue->expr+lvalue->elen && (lvalue->emode&ARITH_LATE))
+	{
+		/* bind plain variable name of cached expression now */
+		c = cp[flag];
+		cp[flag] = 0;
+		np = nv_open(cp,sh.var_tree,NV_NOREF|NV_VARNAME);
+		cp[flag] = c;
+		c = flag = 0;
+	}
+	else if(cp>=lvalue->expr &&  cp < lvalue->expr+lvalue->elen)
 	{
 		int offset;
 		/* do binding to node now */
@@ -193,6 +215,24 @@ static Namval_t *scope(register Namval_t *np,register struct lval *lvalue,int as
 	return(np);
 }
 
+/*
+ * If <np> is a signed integer variable without disciplines, store its value
+ * in <*rp> and return 1. The value is then known to be an exact integer and
+ * arith_exec() can skip the type check it does for other values.
+ */
+static int getint(register Namval_t *np, Sfdouble_t *rp)
+{
+	if(np->nvfun || sh.argaddr || nv_isattr(np,NV_DOUBLE|NV_UNSIGN|NV_SHORT|NV_REF)!=NV_INTEGER)
+		return(0);
+	if(!np->nvalue.lp || np->nvalue.cp==Empty)
+		*rp = 0;
+	else if(nv_isattr(np,NV_LONG))
+		*rp = *np->nvalue.llp;
+	else
+		*rp = *np->nvalue.lp;
+	return(1);
+}
+
 static Math_f sh_mathstdfun(const char *fname, size_t fsize, short * nargs)
 {
 	register const struct mathtab *tp;
@@ -218,7 +258,7 @@ int	sh_mathstd(const char *name)
 
 static Sfdouble_t arith(const char **ptr, struct lval *lvalue, int type, Sfdouble_t n)
 {
-	register Sfdouble_t r= 0;
+	Sfdouble_t r= 0;
 	char *str = (char*)*ptr;
 	register char *cp;
 	switch(type)
@@ -252,7 +292,8 @@ static Sfdouble_t arith(const char **ptr, struct lval *lvalue, int type, Sfdoubl
 		if(lvalue->eflag)
 			lvalue->ptr = (void*)nv_hasdisc(np,&ENUM_disc);
 		lvalue->eflag = 0;
-		r=nv_getnum(np);
+		if(!getint(np,&r))
+			r = nv_getnum(np);
 		lvalue->value = (char*)np;
 		break;
 	    }
@@ -297,6 +338,8 @@ static Sfdouble_t arith(const char **ptr, struct lval *lvalue, int type, Sfdoubl
 				stkseek(sh.stk,off);
 				if(np=nv_search(stkptr(sh.stk,off),sh.fun_tree,0))
 				{
+						if(lvalue->emode&ARITH_LATE)
+							nocache = 1;
 						lvalue->nargs = -np->nvalue.rp->argc;
 						lvalue->fun = (Math_f)np;
 						break;
@@ -311,6 +354,19 @@ static Sfdouble_t arith(const char **ptr, struct lval *lvalue, int type, Sfdoubl
 					lvalue->value = (char*)ERROR_dictionary(e_function);
 				return(r);
 			}
+			if(lvalue->emode&ARITH_LATE)
+			{
+				/* only plain variable names can be bound at execution time */
+				cp = (char*)*ptr;
+				if(dot || c=='[' || str-cp==3 && (strncasecmp(cp,"inf",3)==0 || strncasecmp(cp,"nan",3)==0))
+					nocache = 1;
+				else
+				{
+					lvalue->value = cp;
+					lvalue->flag = str-cp;
+					break;
+				}
+			}
 			if((lvalue->emode&ARITH_COMP) && dot)
 			{
 				lvalue->value = (char*)*ptr;
@@ -497,6 +553,8 @@ static Sfdouble_t arith(const char **ptr, struct lval *lvalue, int type, Sfdoubl
 			lvalue->emode |= 010;
 			return(0);
 		}
+		if(lvalue->isint = getint(np,&r))
+			return(r);
 		r = nv_getnum(np);
 		if(nv_isattr(np,NV_INTEGER|NV_BINARY)==(NV_INTEGER|NV_BINARY))
 			lvalue->isfloat= (r!=(Sflong_t)r);
@@ -519,6 +577,118 @@ static Sfdouble_t arith(const char **ptr, struct lval *lvalue, int type, Sfdoubl
 	return(r);
 }
 
+/*
+ * Return the compiled code for the expression of <len> bytes at <str>.
+ * If it is not in the cache and <add> is set, it is compiled and added;
+ * NULL is returned if it is not in the cache and can't be added.
+ * Variable names in cached code are bound at execution time (ARITH_LATE)
+ * so that the code stays valid when variables come and go.
+ * Expressions with subscripts, compound variable names or calls to
+ * user-defined math functions are not cached.
+ */
+static Arith_t *arith_cached(const char *str, int len, int mode, int add)
+{
+	register struct Arithcache	*cp;
+	register unsigned int		h = 0;
+	register int			n;
+	int				key, offset;
+	char				*sp=0, *expr, *last;
+	Arith_t				*ep;
+	if(sh_isoption(SH_NOEXEC) || len>=SHRT_MAX)
+		return(0);
+	key = mode | sh.radixpoint<<8;
+	if(sh_isoption(sh.bltinfun==b_let ? SH_LETOCTAL : SH_POSIX))
+		key |= 0x10000;
+	for(n=0; n < len; n++)
+		h = h*31 + ((unsigned char*)str)[n];
+	cp = &arithcache[(h ^ h>>7) & (ARITHCACHE-1)];
+	if(cp->ep && cp->hash==h && cp->len==len && cp->key==key && memcmp(cp->expr,str,len)==0)
+		return(cp->ep);
+	/* don't free code that may be executing */
+	if(!add || cp->ep && sh.arithrecursion)
+		return(0);
+	expr = sh_malloc(len+2);
+	memcpy(expr,str,len);
+	expr[len] = expr[len+1] = 0;
+	if(offset=staktell())
+		sp = stakfreeze(1);
+	nocache = 0;
+	ep = arith_compile(expr,&last,arith,ARITH_COMP|ARITH_LATE|mode);
+	if(!ep || nocache || *last)
+	{
+		if(sp)
+			stakset(sp,offset);
+		else if(ep)
+			stakset((char*)ep,0);
+		free(expr);
+		return(0);
+	}
+	n = sizeof(Arith_t)+ep->size;
+	if(cp->ep)
+	{
+		free(cp->ep);
+		free(cp->expr);
+	}
+	cp->ep = sh_malloc(n);
+	memcpy(cp->ep,ep,n);
+	stakset(sp?sp:(char*)ep,offset);
+	cp->ep->code = (unsigned char*)(cp->ep+1);
+	cp->ep->emode = mode|ARITH_LATE;
+	cp->expr = expr;
+	cp->hash = h;
+	cp->len = len;
+	cp->key = key;
+	return(cp->ep);
+}
+
+/*
+ * <str> points to the text of an arithmetic expansion $((...)) after the $.
+ * If <expr> is NULL, return the cached code for it and set <*len> to the
+ * length of the text, or return NULL if it is not in the cache.
+ * Otherwise, <expr> is the raw expression the parser has found in <len>
+ * bytes of text at <str>; if it is exactly the text between the (( and )),
+ * compile and cache it.
+ */
+void *sh_arithdol(const char *str, const char *expr, int *len)
+{
+	register const char	*cp = str+2;
+	register int		c, n=0;
+	Arith_t			*ep;
+	if(str[0]!='(' || str[1]!='(')
+		return(0);
+	/* find the closing )) without parsing, giving up on anything special */
+	while(c = *cp++)
+	{
+		if(c=='(')
+			n++;
+		else if(c==')')
+		{
+			if(n==0)
+			{
+				if(*cp!=')')
+					return(0);
+				break;
+			}
+			n--;
+		}
+		else if(c=='$' || c=='`' || c=='\\' || c=='\'' || c=='"' || c=='\n')
+			return(0);
+	}
+	if(!c)
+		return(0);
+	n = cp-1-(str+2);
+	if(expr)
+	{
+		if(*len!=n+4 || strlen(expr)!=n || memcmp(expr,str+2,n))
+			return(0);
+		return((void*)arith_cached(expr,n,1,1));
+	}
+	c = (cp-str)+1;
+	if(ep = arith_cached(str+2,n,1,0))
+		*len = c;
+	return((void*)ep);
+}
+
 /*
  * convert number defined by string to a Sfdouble_t
  * ptr is set to the last character processed
@@ -557,7 +727,13 @@ Sfdouble_t sh_strnum(register const char *str, char** ptr, int mode)
 				d = 0.0;
 			else
 			{
-				if(!last || *last!=sh.radixpoint || last[1]!=sh.radixpoint)
+				Arith_t *ep;
+				if(!ptr && mode>0 && (ep = arith_cached(str,strlen(str),mode,1)))
+				{
+					d = arith_exec(ep);
+					last = (char*)str+ep->elen;
+				}
+				else if(!last || *last!=sh.radixpoint || last[1]!=sh.radixpoint)
 					d = arith_strval(str,&last,arith,mode);
 				if(!ptr && *last && mode>0)
 				{
@@ -32,12 +32,14 @@
 
 #define NUMSIZE	11
 #define is_associative(ap)	array_assoc((Namarr_t*)(ap))
+#define array_dtmeth(ap)	(((Namarr_t*)(ap))->fun==nv_hashassoc?Dtset:Dtoset)
 #define array_setbit(cp, n, b)	(cp[n] |= (b))
 #define array_clrbit(cp, n, b)	(cp[n] &= ~(b))
 #define array_isbit(cp, n, b)	(cp[n] & (b))
 #define NV_CHILD		NV_EXPORT
 #define ARRAY_CHILD		1
 #define ARRAY_NOFREE		2
+#define ARRAY_PACK		256	/* numeric values per storage block */
 
 struct index_array
 {
@@ -46,6 +48,8 @@ struct index_array
         int		cur;    /* index of current element */
         int		maxi;   /* maximum index for array */
 	unsigned char	*bits;	/* bit array for child subscripts */
+	char		**packed; /* storage blocks for numeric values */
+	size_t		psize;	/* size of a value in packed storage */
         union Value	val[1]; /* array of value holders */
 };
 
@@ -76,6 +80,56 @@ struct assoc_array
    static void array_fixed_setdata(Namval_t*,Namarr_t*,struct fixed_array*);
 #endif /* SHOPT_FIXEDARRAY */
 
+/*
+ * The numeric values of typed indexed arrays are stored in blocks of
+ * ARRAY_PACK slots instead of being allocated one at a time. Slot <i> is
+ * only ever used for element <i>, so whether a value pointer refers to
+ * packed storage can be checked without a search. The slots are as wide
+ * as the value type of the array when the first block was allocated.
+ * If <size> is non-zero, a missing block of values of that size is
+ * allocated and the slot is cleared.
+ */
+static char *array_slot(register struct index_array *ap, int i, size_t size)
+{
+	register char *bp = 0;
+	int n = i/ARRAY_PACK;
+	if(ap->packed)
+		bp = ap->packed[n];
+	if(!bp)
+	{
+		if(!size)
+			return(NIL(char*));
+		if(!ap->packed)
+		{
+			ap->packed = sh_newof(NIL(char**),char*,(ap->maxi+ARRAY_PACK-1)/ARRAY_PACK,0);
+			ap->psize = size;
+		}
+		bp = ap->packed[n] = sh_newof(NIL(char*),char,ARRAY_PACK*ap->psize,0);
+	}
+	bp += (i%ARRAY_PACK)*ap->psize;
+	if(size)
+		memset((void*)bp,0,ap->psize);
+	return(bp);
+}
+
+#define array_ispacked(ap,i)	((ap)->packed && (ap)->val[i].cp && (ap)->val[i].cp==array_slot(ap,i,0))
+
+/*
+ * Numeric values are packed unless they are stored in the node itself
+ */
+#define array_packable(np)	(nv_isattr(np,NV_INTEGER) && (nv_isattr(np,NV_DOUBLE)==NV_DOUBLE || !nv_isattr(np,NV_SHORT)) && !nv_type(np))
+
+static void array_freepack(register struct index_array *ap)
+{
+	register int n;
+	if(!ap->packed)
+		return;
+	for(n=(ap->maxi+ARRAY_PACK-1)/ARRAY_PACK; --n>=0;)
+		free((void*)ap->packed[n]);
+	free((void*)ap->packed);
+	ap->packed = 0;
+}
+
 static Namarr_t *array_scope(Namval_t *np, Namarr_t *ap, int flags)
 {
 	Namarr_t *aq;
@@ -92,7 +146,7 @@ static Namarr_t *array_scope(Namval_t *np, Namarr_t *ap, int flags)
 	aq->hdr.nofree |= (flags&NV_RDONLY)?1:0;
 	if(is_associative(aq))
 	{
-		aq->scope = (void*)dtopen(&_Nvdisc,Dtoset);
+		aq->scope = (void*)dtopen(&_Nvdisc,array_dtmeth(aq));
 		dtview((Dt_t*)aq->scope,aq->table);
 		aq->table = (Dt_t*)aq->scope;
 		return(aq);
@@ -113,6 +167,7 @@ static Namarr_t *array_scope(Namval_t *np, Namarr_t *ap, int flags)
 	ar = (struct index_array*)aq;
 	memset(ar->val, 0, ar->maxi*sizeof(char*));
 	ar->bits =  (unsigned char*)&ar->val[ar->maxi];
+	ar->packed = 0;
 	return(aq);
 }
 
@@ -123,6 +178,8 @@ static int array_unscope(Namval_t *np,Namarr_t *ap)
 		return(0);
 	if(is_associative(ap))
 		(*ap->fun)(np, NIL(char*), NV_AFREE);
+	else if(!ap->fixed)
+		array_freepack((struct index_array*)ap);
 	if((fp = nv_disc(np,(Namfun_t*)ap,NV_POP)) && !(fp->nofree&1))
 		free((void*)fp);
 	nv_delete(np,(Dt_t*)0,0);
@@ -230,7 +287,7 @@ static union Value *array_getup(Namval_t *np, Namarr_t *arp, int update)
 			UNREACHABLE();
 		}
 		up = &(ap->val[ap->cur]);
-		nofree = array_isbit(ap->bits,ap->cur,ARRAY_NOFREE);
+		nofree = array_isbit(ap->bits,ap->cur,ARRAY_NOFREE) || array_ispacked(ap,ap->cur);
 	}
 	if(update)
 	{
@@ -471,7 +528,7 @@ static Namfun_t *array_clone(Namval_t *np, Namval_t *mp, int flags, Namfun_t *fp
 	}
 	if(ap->table)
 	{
-		ap->table = dtopen(&_Nvdisc,Dtoset);
+		ap->table = dtopen(&_Nvdisc,array_dtmeth(ap));
 		if(ap->scope && !(flags&NV_COMVAR))
 		{
 			ap->scope = ap->table;
@@ -485,7 +542,14 @@ static Namfun_t *array_clone(Namval_t *np, Namval_t *mp, int flags, Namfun_t *fp
 		sub = sh_strdup(sub);
 	ar = (struct index_array*)ap;
 	if(!is_associative(ap))
+	{
 		ar->bits = (unsigned char*)&ar->val[ar->maxi];
+		/* borrowed values stay in the packed storage, which moves to the copy */
+		if((flags&(NV_ARRAY|NV_NOFREE))==(NV_ARRAY|NV_NOFREE))
+			aq->packed = 0;
+		else
+			ar->packed = 0;
+	}
 	if(!nv_putsub(np,NIL(char*),ARRAY_SCAN|((flags&NV_COMVAR)?0:ARRAY_NOSCOPE)))
 	{
 		if(ap->fun)
@@ -681,6 +745,28 @@ static void array_putval(Namval_t *np, const char *string, int flags, Namfun_t *
 		up = array_getup(np,ap,!nofree);
 		if(up->cp ==  Empty)
 			up->cp = 0;
+		if(string && !ap->fixed && !is_associative(ap) && array_packable(np) && !array_isbit(aq->bits,aq->cur,ARRAY_CHILD))
+		{
+			size_t size = nv_datasize(np,(size_t*)0);
+			if(aq->packed && size > aq->psize)
+			{
+				/* the value type outgrew the packed slots; use separate storage */
+				if(array_ispacked(aq,aq->cur))
+				{
+					up->cp = 0;
+					nv_offattr(np,NV_NOFREE);
+				}
+			}
+			else if(!up->cp || array_isbit(aq->bits,aq->cur,ARRAY_NOFREE))
+			{
+				/* store the value in packed storage; a borrowed value is copied, not overwritten */
+				char *cp = array_slot(aq,aq->cur,size);
+				if(up->cp)
+					memcpy(cp,up->cp,size);
+				up->cp = cp;
+				nv_onattr(np,NV_NOFREE);
+			}
+		}
 #if SHOPT_FIXEDARRAY
 		if(nv_isarray(np) && !ap->fixed)
 #else
@@ -750,6 +836,8 @@ static void array_putval(Namval_t *np, const char *string, int flags, Namfun_t *
 		}
 		if((nfp = nv_disc(np,(Namfun_t*)ap,NV_POP)) && !(nfp->nofree&1))
 		{
+			if(!is_associative(ap) && !ap->fixed)
+				array_freepack(aq);
 			ap = 0;
 			free((void*)nfp);
 		}
@@ -829,6 +917,14 @@ static struct index_array *array_grow(Namval_t *np, register struct index_array
 			ap->val[i].cp = arp->val[i].cp;
 		}
 		memcpy(ap->bits, arp->bits, arp->maxi);
+		if(ap->packed = arp->packed)
+		{
+			int n = (arp->maxi+ARRAY_PACK-1)/ARRAY_PACK;
+			int m = (newsize+ARRAY_PACK-1)/ARRAY_PACK;
+			ap->packed = (char**)sh_realloc(ap->packed,m*sizeof(char*));
+			memset((void*)&ap->packed[n],0,(m-n)*sizeof(char*));
+			ap->psize = arp->psize;
+		}
 		array_setptr(np,arp,ap);
 		free((void*)arp);
 	}
@@ -952,11 +1048,15 @@ static Namarr_t *nv_changearray(Namval_t *np, void *(*fun)(Namval_t*,const char*
 			}
 			nv_putsub(np, string_index, ARRAY_ADD);
 			up = (union Value*)((*ap->fun)(np,NIL(char*),0));
-			up->cp = save_ap->val[dot].cp;
+			if(array_ispacked(save_ap,dot))
+				up->cp = (char*)sh_memdup(save_ap->val[dot].cp,save_ap->psize);
+			else
+				up->cp = save_ap->val[dot].cp;
 			save_ap->val[dot].cp = 0;
 		}
 		string_index = &numbuff[NUMSIZE];
 	}
+	array_freepack(save_ap);
 	free((void*)save_ap);
 	return(ap);
 }
@@ -979,6 +1079,12 @@ Namarr_t *nv_setarray(Namval_t *np, void *(*fun)(Namval_t*,const char*,int))
 		 */
 		if(!is_associative(ap))
 			ap = nv_changearray(np, fun);
+		else if(fun==nv_hashassoc && ap->fun==nv_associative && !ap->scope)
+		{
+			/* typeset -A -U on an existing associative array */
+			ap->fun = fun;
+			dtmethod(ap->table,Dtset);
+		}
 		return(ap);
 	}
 	if(nv_isnull(np) && nv_isattr(np,NV_NOFREE))
@@ -1774,9 +1880,17 @@ void *nv_associative(register Namval_t *np,const char *sp,int mode)
 			else if(ap->header.nelem&ARRAY_SCAN)
 			{
 				Namval_t fake;
-				fake.nvname = (char*)sp;
-				ap->pos = mp = (Namval_t*)dtprev(ap->header.table,&fake);
-				ap->nextpos = (Namval_t*)dtnext(ap->header.table,mp);
+				if(ap->header.fun==nv_hashassoc)
+				{
+					/* a hash table has no order, so resume the scan at <sp> itself */
+					ap->pos = ap->nextpos = mp;
+				}
+				else
+				{
+					fake.nvname = (char*)sp;
+					ap->pos = mp = (Namval_t*)dtprev(ap->header.table,&fake);
+					ap->nextpos = (Namval_t*)dtnext(ap->header.table,mp);
+				}
 			}
 			else if(!mp && *sp && mode==0)
 				mp = nv_search(sp,ap->header.table,NV_ADD|NV_NOSCOPE);
@@ -1794,6 +1908,22 @@ void *nv_associative(register Namval_t *np,const char *sp,int mode)
 	}
 }
 
+/*
+ * This implementation is used for associative arrays declared with
+ * typeset -A -U. The subscripts are kept in a hash table instead of an
+ * ordered set, so elements are added and found in constant time, but
+ * they are not listed in sorted order.
+ */
+void *nv_hashassoc(register Namval_t *np,const char *sp,int mode)
+{
+	register Namarr_t *ap;
+	if(mode!=NV_AINIT)
+		return(nv_associative(np,sp,mode));
+	ap = (Namarr_t*)nv_associative(np,sp,mode);
+	dtmethod(ap->table,Dtset);
+	return((void*)ap);
+}
+
 /*
  * Assign values to an array
  */
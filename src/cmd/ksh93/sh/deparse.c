@@ -277,6 +277,13 @@ static void p_tree(register const Shnode_t *t,register int tflags)
 		case TFOR:
 			cp = ((t->tre.tretyp&COMSCAN)?"select":"for");
 			p_keyword(cp,BEGIN|NOTAB);
+			if(t->tre.tretyp&FPARFOR)
+			{
+				sfputr(outfile,"-P",' ');
+				p_arg(t->for_.forpar,' ',0);
+				if(t->tre.tretyp&FKEEP)
+					sfputr(outfile,"-k",' ');
+			}
 			sfputr(outfile,t->for_.fornam,' ');
 			if(t->for_.forlst)
 			{
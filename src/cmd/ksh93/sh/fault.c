@@ -677,6 +677,9 @@ noreturn void sh_done(register int sig)
 #if SHOPT_ACCT
 	sh_accend();
 #endif	/* SHOPT_ACCT */
+#if SHOPT_STATS
+	sh_profend();
+#endif /* SHOPT_STATS */
 	if(mbwide() && sh_editor_active())
 		tty_cooked(-1);
 #ifdef JOBS
@@ -236,10 +236,18 @@ static noreturn char *nomemory(size_t s)
 /*
  * The following are wrapper functions for memory allocation.
  * These functions will error out if the allocation fails.
+ * Calls are counted for the profiler (see profile.c).
  */
+#if SHOPT_STATS
+#   define nalloc()	(sh.nalloc++)
+#else
+#   define nalloc()
+#endif /* SHOPT_STATS */
+
 void *sh_malloc(size_t size)
 {
 	void *cp = malloc(size);
+	nalloc();
 	if(!cp)
 		nomemory(size);
 	return(cp);
@@ -248,6 +256,7 @@ void *sh_malloc(size_t size)
 void *sh_realloc(void *ptr, size_t size)
 {
 	void *cp = realloc(ptr, size);
+	nalloc();
 	if(!cp)
 		nomemory(size);
 	return(cp);
@@ -256,6 +265,7 @@ void *sh_realloc(void *ptr, size_t size)
 void *sh_calloc(size_t nmemb, size_t size)
 {
 	void *cp = calloc(nmemb, size);
+	nalloc();
 	if(!cp)
 		nomemory(size);
 	return(cp);
@@ -264,6 +274,7 @@ void *sh_calloc(size_t nmemb, size_t size)
 char *sh_strdup(const char *s)
 {
 	char *dup = strdup(s);
+	nalloc();
 	if(!dup)
 		nomemory(strlen(s)+1);
 	return(dup);
@@ -272,6 +283,7 @@ char *sh_strdup(const char *s)
 void *sh_memdup(const void *s, size_t n)
 {
 	void *dup = memdup(s, n);
+	nalloc();
 	if(!dup)
 		nomemory(n);
 	return(dup);
@@ -1359,6 +1371,7 @@ Shell_t *sh_init(register int argc,register char *argv[], Shinit_f userinit)
 	}
 	*SHLVL->nvalue.ip +=1;
 	nv_offattr(SHLVL,NV_IMPORT);
+	env_change();
 #if SHOPT_SPAWN
 	{
 		/*
@@ -1664,6 +1677,7 @@ int sh_reinit(char *argv[])
 	}
 	*SHLVL->nvalue.ip +=1;
 	nv_offattr(SHLVL,NV_IMPORT);
+	env_change();
 	sh.st.filename = sh_strdup(sh.lastarg);
 	nv_delete((Namval_t*)0, (Dt_t*)0, 0);
 	job.exitval = 0;
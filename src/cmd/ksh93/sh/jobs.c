@@ -50,9 +50,14 @@
 #include	"shopt.h"
 #include	"defs.h"
 #include	<wait.h>
+#include	<tmx.h>
 #include	"io.h"
 #include	"jobs.h"
 #include	"history.h"
+#include	"FEATURE/poll"
+#if _lib_syspidfd
+#   include	<sys/syscall.h>
+#endif
 
 #if !defined(WCONTINUED) || !defined(WIFCONTINUED)
 #   undef  WCONTINUED
@@ -62,6 +67,8 @@
 #endif
 
 #define	NJOB_SAVELIST	4
+#define PIDHASH		512	/* number of PID hash chains; a power of 2 */
+#define pidhash(pid)	((unsigned)(pid)&(PIDHASH-1))
 
 /*
  * temporary hack to get W* macros to work
@@ -71,18 +78,31 @@
 /*
  * This struct saves a link list of processes that have non-zero exit
  * status, have had $! saved, but haven't been waited for
+ * Each one is also on a PID hash chain; <level> is the subshell
+ * level of the back_save list that it is on
  */
 struct jobsave
 {
 	struct jobsave	*next;
+	struct jobsave	*prev;
+	struct jobsave	*nxtpid;
 	pid_t		pid;
+	int		level;
 	unsigned short	exitval;
+	char		infork;	/* reaped while a spawned process was not yet posted */
 };
 
 static struct jobsave *job_savelist;
+static struct jobsave *savetab[PIDHASH];
+static struct process *pidtab[PIDHASH];
+static struct process **jobtab;	/* first process of each job by job number */
+static int njobtab;
 static int njob_savelist;
 static struct process *pwfg;
 static int jobfork;
+static void *waittimer;		/* timer for wait -t */
+static Time_t waitdeadline;
+static char waittimedout;
 
 pid_t	pid_fromstring(char *str)
 {
@@ -116,6 +136,7 @@ static void init_savelist(void)
 struct back_save
 {
 	int		count;
+	int		level;
 	struct jobsave	*list;
 	struct back_save *prev;
 };
@@ -154,7 +175,10 @@ struct back_save
 #define P_BG		01000	/* set if the process is running in the background */
 
 static int		job_chksave(pid_t);
+static void		jobsave_unlink(struct back_save*,struct jobsave*);
 static struct process	*job_bypid(pid_t);
+static void		job_unhash(struct process*);
+static int		job_timedwait(struct process*);
 static struct process	*job_byjid(int);
 static char		*job_sigmsg(int);
 static int		job_alloc(void);
@@ -268,9 +292,15 @@ static struct jobsave *jobsave_create(pid_t pid)
 	if(jp)
 	{
 		jp->pid = pid;
-		jp->next = bck.list;
+		jp->level = bck.level;
+		jp->prev = 0;
+		if(jp->next = bck.list)
+			jp->next->prev = jp;
 		bck.list = jp;
+		jp->nxtpid = savetab[pidhash(pid)];
+		savetab[pidhash(pid)] = jp;
 		jp->exitval = 0;
+		jp->infork = 0;
 	}
 	return(jp);
 }
@@ -359,7 +389,8 @@ int job_reap(register int sig)
 			pw->p_exitmin = 0;
 			if(job.toclear)
 				job_clear();
-			jp = jobsave_create(pid);
+			if((jp = jobsave_create(pid)) && jobfork)
+				jp->infork = 1;
 			pw->p_flag = 0;
 			lastpid = pw->p_pid = pid;
 			px = 0;
@@ -798,17 +829,33 @@ static void job_reset(register struct process *pw)
 }
 #endif /* JOBS */
 
+/*
+ * timer action for wait -t
+ */
+static void job_waittimeout(void *handle)
+{
+	NOT_USED(handle);
+	waittimedout = 1;
+}
+
 /*
  * wait built-in command
+ * if <timeout> is non-zero, give up after <timeout> milliseconds
  */
-void job_bwait(char **jobs)
+void job_bwait(char **jobs, long timeout)
 {
 	register char *jp;
 	register struct process *pw;
 	register pid_t pid;
+	waittimedout = 0;
+	if(timeout)
+	{
+		waitdeadline = TMX_NOW + (Time_t)timeout*(TMX_RESOLUTION/1000);
+		waittimer = sh_timeradd(timeout,0,job_waittimeout,NIL(void*));
+	}
 	if(*jobs==0)
 		job_wait((pid_t)-1);
-	else while(jp = *jobs++)
+	else while(!waittimedout && (jp = *jobs++))
 	{
 #ifdef JOBS
 		if(*jp == '%')
@@ -826,6 +873,13 @@ void job_bwait(char **jobs)
 			pid = pid_fromstring(jp);
 		job_wait(-pid);
 	}
+	if(timeout)
+	{
+		sh_timerdel(waittimer);
+		waittimer = 0;
+		if(waittimedout)
+			sh.exitval = 128+SIGALRM;
+	}
 }
 
 #ifdef JOBS
@@ -1182,12 +1236,16 @@ void	job_clear(void)
 			free((void*)px);
 		}
 	}
+	memset(pidtab,0,sizeof(pidtab));
+	if(jobtab)
+		memset(jobtab,0,njobtab*sizeof(struct process*));
 	for(jp=bck.list; jp;jp=jpnext)
 	{
 		jpnext = jp->next;
+		jobsave_unlink(&bck,jp);
 		free((void*)jp);
 	}
-	bck.list = 0;
+	bck.count = 0;
 	if(njob_savelist < NJOB_SAVELIST)
 		init_savelist();
 	job.pwlist = NIL(struct process*);
@@ -1214,8 +1272,9 @@ int job_post(pid_t pid, pid_t join)
 {
 	register struct process *pw;
 	register History_t *hp = sh.hist_ptr;
+	struct jobsave *jp;
 	int val;
-	char bg = 0;
+	char bg = 0, infork;
 	sh.jobenv = sh.curenv;
 	if(job.toclear)
 	{
@@ -1269,14 +1328,25 @@ int job_post(pid_t pid, pid_t join)
 			job_wait((pid_t)1);
 		pw->p_nxtjob = job.pwlist;
 		pw->p_nxtproc = 0;
+		if(pw->p_job >= njobtab)
+		{
+			val = njobtab;
+			njobtab = 2*pw->p_job+16;
+			jobtab = sh_newof(jobtab,struct process*,njobtab,0);
+			memset(&jobtab[val],0,(njobtab-val)*sizeof(struct process*));
+		}
 	}
+	jobtab[pw->p_job] = pw;
 	pw->p_exitval = job.exitval; 
 	job.pwlist = pw;
 	pw->p_env = sh.curenv;
 	pw->p_pid = pid;
+	pw->p_nxtpid = pidtab[pidhash(pid)];
+	pidtab[pidhash(pid)] = pw;
 	if(!sh.outpipe || sh.cpid==pid)
 		pw->p_flag = P_EXITSAVE;
 	pw->p_exitmin = sh.xargexit;
+	sh.xargexit = 0;
 	pw->p_exit = 0;
 	if(sh_isstate(SH_MONITOR))
 	{
@@ -1298,7 +1368,13 @@ int job_post(pid_t pid, pid_t join)
 	else
 		pw->p_name = -1;
 #endif /* JOBS */
-	if ((val = job_chksave(pid))>=0 && !jobfork)
+	/*
+	 * A status saved while forking is normally left over from an earlier process with the same PID,
+	 * unless it was reaped in the meantime, as the last pass of 'command -x -P' may be
+	 */
+	for(jp=savetab[pidhash(pid)]; jp && jp->pid!=pid; jp=jp->nxtpid);
+	infork = jp && jp->infork;
+	if ((val = job_chksave(pid))>=0 && (!jobfork || infork))
 	{
 		pw->p_exit = val;
 		if(pw->p_exit==SH_STOPSIG)
@@ -1312,7 +1388,11 @@ int job_post(pid_t pid, pid_t join)
 			pw->p_exit &= SH_EXITMASK;
 		}
 		else
+		{
 			pw->p_flag |= (P_DONE|P_NOTIFY);
+			if(pw->p_exit < pw->p_exitmin)
+				pw->p_exit = pw->p_exitmin;
+		}
 	}
 	if(bg)
 	{
@@ -1333,28 +1413,39 @@ int job_post(pid_t pid, pid_t join)
  */
 static struct process *job_bypid(pid_t pid)
 {
-	register struct process  *pw, *px;
-	for(pw=job.pwlist; pw; pw=pw->p_nxtjob)
-		for(px=pw; px; px=px->p_nxtproc)
-		{
-			if(px->p_pid==pid)
-				return(px);
-		}
+	register struct process  *pw;
+	for(pw=pidtab[pidhash(pid)]; pw; pw=pw->p_nxtpid)
+	{
+		if(pw->p_pid==pid)
+			return(pw);
+	}
 	return(NIL(struct process*));
 }
 
 /*
- * return a pointer to a job given the job ID
+ * remove a process from its PID hash chain
  */
-static struct process *job_byjid(int jobid)
+static void job_unhash(register struct process *pw)
 {
-	register struct process *pw;
-	for(pw=job.pwlist;pw; pw = pw->p_nxtjob)
+	register struct process **pp = &pidtab[pidhash(pw->p_pid)];
+	for(; *pp; pp = &(*pp)->p_nxtpid)
 	{
-		if(pw->p_job==jobid)
+		if(*pp==pw)
+		{
+			*pp = pw->p_nxtpid;
 			break;
+		}
 	}
-	return(pw);
+}
+
+/*
+ * return a pointer to a job given the job ID
+ */
+static struct process *job_byjid(int jobid)
+{
+	if(jobid>0 && jobid<njobtab)
+		return(jobtab[jobid]);
+	return(NIL(struct process*));
 }
 
 /*
@@ -1389,7 +1480,7 @@ int	job_wait(register pid_t pid)
 {
 	register struct process *pw=0,*px;
 	register int	jobid = 0;
-	int		nochild = 1;
+	int		nochild = 1, n;
 	char		intr = 0;
 	if(pid < 0)
 	{
@@ -1523,7 +1614,17 @@ int	job_wait(register pid_t pid)
 		}
 		sfsync(sfstderr);
 		job.waitsafe = 0;
-		nochild = job_reap(job.savesig);
+		if(waittimer && intr)
+		{
+			/* wait -t */
+			if(waittimedout || (n=job_timedwait(pw))==0)
+				break;
+			nochild = job_reap(n>0 ? SIGCHLD : job.savesig);
+			if(waittimedout)
+				break;
+		}
+		else
+			nochild = job_reap(job.savesig);
 		if(job.waitsafe)
 			continue;
 		if(nochild)
@@ -1582,6 +1683,112 @@ done:
 	return(nochild);
 }
 
+/*
+ * Wait for process <pw>, or for any process in the job list if <pw> is NULL,
+ * to become ready to be reaped, or for the wait -t deadline to pass.
+ * On Linux, this polls pidfds for the processes until the deadline;
+ * the wait -t timer interrupts the poll for early timer and trap handling.
+ * Returns 0 on timeout, >0 when a process is ready or the wait was interrupted,
+ * and -1 if pidfds cannot be used; the caller then does a blocking reap,
+ * which the timer interrupts.
+ */
+static int job_timedwait(struct process *pw)
+{
+	Time_t now = TMX_NOW;
+	if(now >= waitdeadline)
+	{
+		waittimedout = 1;
+		return(0);
+	}
+#if _lib_syspidfd
+	{
+		struct process	*px, *pj;
+		struct pollfd	*fds;
+		Time_t		msec = (waitdeadline-now+999999)/1000000;
+		int		i, n=0, r=0, oerrno=errno;
+		if(pw)
+			n = 1;
+		else for(pj=job.pwlist; pj; pj=pj->p_nxtjob)
+			for(px=pj; px; px=px->p_nxtproc)
+				n += !(px->p_flag&P_DONE);
+		if(n==0)
+			return(1);
+		fds = (struct pollfd*)sh_malloc(n*sizeof(struct pollfd));
+		for(i=0,pj=(pw?pw:job.pwlist); i<n && pj; pj=pj->p_nxtjob)
+		{
+			for(px=pj; i<n && px; px=(pw?0:px->p_nxtproc))
+			{
+				if(!pw && (px->p_flag&P_DONE))
+					continue;
+				if((fds[i].fd = syscall(SYS_pidfd_open,px->p_pid,0)) < 0)
+				{
+					/* a process that is gone is reaped right away */
+					r = errno==ESRCH ? 1 : -1;
+					goto done;
+				}
+				fds[i++].events = POLLIN;
+			}
+		}
+		if((r = poll(fds,i,msec>INT_MAX?INT_MAX:(int)msec)) < 0)
+			r = 1;
+		else if(r==0)
+			waittimedout = 1;
+	done:
+		while(i-- > 0)
+			close(fds[i].fd);
+		free((void*)fds);
+		errno = oerrno;
+		return(r);
+	}
+#else
+	NOT_USED(pw);
+	return(-1);
+#endif
+}
+
+/*
+ * Wait for any one of the <n> processes in <pids> to complete
+ * Entries that are 0 are skipped
+ * The index of the completed process is returned and its exit status
+ * is left in sh.exitval; -1 is returned if there is nothing to wait for
+ */
+int job_waitany(pid_t *pids, int n)
+{
+	register struct process *pw;
+	register int	i, nochild = 0;
+	job_lock();
+	while(1)
+	{
+		for(i=0; i < n; i++)
+		{
+			if(pids[i] && (!(pw=job_bypid(pids[i])) || (pw->p_flag&P_DONE)))
+			{
+				job_unlock();
+				job_wait(pids[i]);
+				return(i);
+			}
+		}
+		if(nochild)
+			break;
+#ifdef JOBS
+		nochild = job_reap(0);
+#else
+		nochild = 1;
+#endif /* JOBS */
+	}
+	job_unlock();
+	/* without a reaper, fall back to waiting for them in order */
+	for(i=0; i < n; i++)
+	{
+		if(pids[i])
+		{
+			job_wait(pids[i]);
+			return(i);
+		}
+	}
+	return(-1);
+}
+
 /*
  * move job to foreground if bgflag == 'f'
  * move job to background if bgflag == 'b'
@@ -1724,6 +1931,7 @@ static struct process *job_unpost(register struct process *pwtop,int notify)
 		}
 		pw->p_flag &= ~P_DONE;
 		job.numpost--;
+		job_unhash(pw);
 		pw->p_nxtjob = freelist;
 		freelist = pw;
 	}
@@ -1732,6 +1940,7 @@ static struct process *job_unpost(register struct process *pwtop,int notify)
 	sfprintf(sfstderr,"ksh: job line %4d: free PID=%lld critical=%d job=%d\n",__LINE__,(Sflong_t)sh.current_pid,job.in_critical,pwtop->p_job);
 	sfsync(sfstderr);
 #endif /* DEBUG */
+	jobtab[pwtop->p_job] = 0;
 	job_free((int)pwtop->p_job);
 	return((struct process*)0);
 }
@@ -1826,36 +2035,28 @@ static char *job_sigmsg(int sig)
  */
 static int job_chksave(register pid_t pid)
 {
-	register struct jobsave *jp = bck.list, *jpold=0;
-	register int r= -1;
-	register int count=bck.count;
+	register struct jobsave *jp;
+	register int r= -1, n;
 	struct back_save *bp= &bck;
-again:
-	while(jp && count-->0)
+	if(pid)
 	{
-		if(jp->pid==pid)
-			break;
-		if(pid==0 && !jp->next)
-			break;
-		jpold = jp;
-		jp = jp->next;
+		for(jp=savetab[pidhash(pid)]; jp && jp->pid!=pid; jp=jp->nxtpid);
+		/* find the list it is on */
+		if(jp)
+			for(n=bck.level-jp->level; n>0; n--)
+				bp = bp->prev;
 	}
-	if(!jp && pid && (bp=bp->prev))
+	else if(jp=bck.list)
 	{
-		count = bp->count;
-		jp = bp->list;
-		jpold = 0;
-		goto again;
+		while(jp->next)
+			jp = jp->next;
 	}
 	if(jp)
 	{
 		r = 0;
 		if(pid)
 			r = jp->exitval;
-		if(jpold)
-			jpold->next = jp->next;
-		else
-			bp->list = jp->next;
+		jobsave_unlink(bp,jp);
 		bp->count--;
 		if(njob_savelist < NJOB_SAVELIST)
 		{
@@ -1869,6 +2070,28 @@ again:
 	return(r);
 }
 
+/*
+ * remove a saved exit status from list <bp> and from its PID hash chain
+ */
+static void jobsave_unlink(struct back_save *bp, register struct jobsave *jp)
+{
+	register struct jobsave **jpp = &savetab[pidhash(jp->pid)];
+	for(; *jpp; jpp = &(*jpp)->nxtpid)
+	{
+		if(*jpp==jp)
+		{
+			*jpp = jp->nxtpid;
+			break;
+		}
+	}
+	if(jp->prev)
+		jp->prev->next = jp->next;
+	else
+		bp->list = jp->next;
+	if(jp->next)
+		jp->next->prev = jp->prev;
+}
+
 void *job_subsave(void)
 {
 	struct back_save *bp = new_of(struct back_save,0);
@@ -1878,6 +2101,7 @@ void *job_subsave(void)
 	bck.count = 0;
 	bck.list = 0;
 	bck.prev = bp;
+	bck.level++;
 	job_unlock();
 	return((void*)bp);
 }
@@ -1891,14 +2115,19 @@ void job_subrestore(void* ptr)
 	job_lock();
 	for(jp=bck.list; jp; jp=jp->next)
 	{
+		jp->level = bp->level;
 		if (!jp->next)
 			end = jp;
 	}
 	if(end)
-		end->next = bp->list;
+	{
+		if(end->next = bp->list)
+			bp->list->prev = end;
+	}
 	else
 		bck.list = bp->list;
 	bck.count += bp->count;
+	bck.level = bp->level;
 	bck.prev = bp->prev;
 	while(bck.count > sh.lim.child_max)
 		job_chksave(0);
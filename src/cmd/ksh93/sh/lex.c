@@ -1464,7 +1464,7 @@ breakloop:
 			}
 			else if(c==FORSYM || c==CASESYM || c==SELECTSYM || c==FUNCTSYM || c==NSPACESYM)
 			{
-				lp->lex.skipword = 1;
+				lp->lex.skipword = 1 + (c==FORSYM);
 				lp->lex.incase = 2*(c==CASESYM);
 			}
 			else
@@ -1494,6 +1494,8 @@ breakloop:
 				&& (state=nv_getval(np)))
 			{
 				setupalias(lp,state,np);
+				if(!nv_isattr(np,NV_NOFREE))
+					lp->aliased = 1;
 				nv_onattr(np,NV_NOEXPAND);
 				lp->lex.reservok = 1;
 				lp->assignok |= lp->lex.reservok;
@@ -1502,7 +1504,14 @@ breakloop:
 		}
 		lp->lex.reservok = 0;
 	}
-	lp->lex.skipword = lp->lexd.docword = 0;
+	/* the options of 'for -P jobs -k name' and their arguments are skipped as well */
+	if(lp->lex.skipword==2 && state[0]=='-')
+		lp->lex.skipword = 2 + (state[1]=='P' && state[2]==0);
+	else if(lp->lex.skipword==3)
+		lp->lex.skipword = 2;
+	else
+		lp->lex.skipword = 0;
+	lp->lexd.docword = 0;
 	return(lp->token=c);
 }
 
@@ -2137,7 +2137,27 @@ static void comsubst(Mac_t *mp,register Shnode_t* t, int type)
 	{
 		sp = 0;
 		fcseek(-1);
-		if(!t)
+		if(!t && !fcfile())
+		{
+			/* use cached code for $((expression)) if possible */
+			char	*cp = fcseek(0);
+			int	len;
+			Arith_t	*ep;
+			if(ep = (Arith_t*)sh_arithdol(cp,NIL(char*),&len))
+			{
+				fcseek(len);
+				fcsave(&save);
+				num = arith_exec(ep);
+				goto out_offset;
+			}
+			t = sh_dolparen((Lex_t*)sh.lex_context);
+			if(t && t->tre.tretyp==TARITH && (t->ar.arexpr->argflag&ARG_RAW) && !fcfile())
+			{
+				len = fcseek(0)-cp;
+				sh_arithdol(cp,t->ar.arexpr->argval,&len);
+			}
+		}
+		else if(!t)
 			t = sh_dolparen((Lex_t*)sh.lex_context);
 		if(t && t->tre.tretyp==TARITH)
 		{
@@ -596,6 +596,9 @@ static void	exfile(register Sfio_t *iop,register int fno)
 			execflags = sh_state(SH_ERREXIT)|sh_state(SH_INTERACTIVE);
 			/* The last command may not have to fork */
 			if(!sh_isstate(SH_PROFILE) && !sh_isstate(SH_INTERACTIVE) &&
+#if SHOPT_STATS
+				!sh_isoption(SH_PROFILING) &&
+#endif /* SHOPT_STATS */
 				(fno<0 || !(sh.fdstatus[fno]&(IOTTY|IONOSEEK)))
 				&& !sfreserve(iop,0,0))
 			{
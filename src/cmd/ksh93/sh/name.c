@@ -32,7 +32,7 @@
 #include	"FEATURE/externs"
 #include	"streval.h"
 
-#define NVCACHE		8	/* must be a power of 2 */
+#define NVCACHE		64	/* must be a power of 2 */
 static char	*savesub = 0;
 static Namval_t	NullNode;
 static Dt_t	*Refdict;
@@ -55,6 +55,7 @@ struct adata
 	Namval_t	*tp;
 	char		*mapname;
 	char		**argnam;
+	int		dynamic;
 };
 
 /* for a 'typeset -T' type */
@@ -82,10 +83,22 @@ struct sh_type
 		short		size;
 		short		len;
 	} entries[NVCACHE];
-	short		index;
 	short		ok;
     };
     static struct Namcache nvcache;
+
+/*
+ * hash the first <len> bytes of <name>, or up to a terminating
+ * 0, '=' or '+' if <len> is negative, into an nvcache index
+ */
+static int nvcache_hash(register const char *name, register int len)
+{
+	register unsigned int	h = 0;
+	register int		c;
+	while(len-- && (c = *(unsigned char*)name++) && (len>=0 || (c!='=' && c!='+')))
+		h = h*31 + c;
+	return((h ^ h>>7) & (NVCACHE-1));
+}
 #endif
 
 char		nv_local = 0;
@@ -476,18 +489,19 @@ void nv_setlist(register struct argnod *arg,register int flags, Namval_t *typ)
 					}
 					else if(((np->nvalue.cp && np->nvalue.cp!=Empty)||nv_isvtree(np)|| nv_arrayptr(np)) && !nv_type(np))
 					{
-						int was_assoc_array = ap && ap->fun;
+						void *(*assoc_fun)(Namval_t*,const char*,int) = (ap=nv_arrayptr(np)) ? ap->fun : 0;
 						_nv_unset(np,NV_EXPORT);  /* this can free ap */
-						if(was_assoc_array)
-							 nv_setarray(np,nv_associative);
+						if(assoc_fun)
+							 nv_setarray(np,assoc_fun);
 					}
 				}
 				else
 				{
+					void *(*assoc_fun)(Namval_t*,const char*,int) = (ap=nv_arrayptr(np)) ? ap->fun : 0;
 					if(!(arg->argflag&ARG_APPEND))
 						_nv_unset(np,NV_EXPORT);
 					if(!(array&NV_IARRAY) && !nv_isarray(np))
-						nv_setarray(np,nv_associative);
+						nv_setarray(np,assoc_fun?assoc_fun:nv_associative);
 				}
 			skip:
 				if(sub>0)
@@ -1369,10 +1383,9 @@ Namval_t *nv_open(const char *name, Dt_t *root, int flags)
 	if(c= !isaletter(c))
 		goto skip;
 #if NVCACHE
-	for(c=0,xp=nvcache.entries ; c < NVCACHE; xp= &nvcache.entries[++c])
+	xp = &nvcache.entries[nvcache_hash(name,-1)];
+	if(xp->root==root)
 	{
-		if(xp->root!=root)
-			continue;
 		if(xp->namespace==sh.namespace && (flags&(NV_ARRAY|NV_NOSCOPE))==xp->flags && strncmp(xp->name,name,xp->len)==0 && (name[xp->len]==0 || name[xp->len]=='=' || name[xp->len]=='+'))
 		{
 			sh_stats(STAT_NVHITS);
@@ -1392,16 +1405,20 @@ Namval_t *nv_open(const char *name, Dt_t *root, int flags)
 #if NVCACHE
 	if(np && nvcache.ok && cp[-1]!=']')
 	{
-		xp = &nvcache.entries[nvcache.index];
 		if(*cp)
 		{
 			char *sp = strchr(name,*cp);
 			if(!sp)
 				goto nocache;
-			xp->len = sp-name;
+			c = sp-name;
 		}
 		else
-			xp->len = strlen(name);
+			c = strlen(name);
+		/* compound variable members can be replaced without being deleted */
+		if(memchr(name+1,'.',c-1))
+			goto nocache;
+		xp = &nvcache.entries[nvcache_hash(name,c)];
+		xp->len = c;
 		c = roundof(xp->len+1,32);
 		if(c > xp->size)
 		{
@@ -1419,7 +1436,6 @@ Namval_t *nv_open(const char *name, Dt_t *root, int flags)
 		xp->last_table = sh.last_table;
 		xp->last_root = sh.last_root;
 		xp->flags = (flags&(NV_ARRAY|NV_NOSCOPE));
-		nvcache.index = (nvcache.index+1)&(NVCACHE-1);
 	}
 nocache:
 	nvcache.ok = 0;
@@ -2111,28 +2127,62 @@ static void pushnam(Namval_t *np, void *data)
 {
 	register char *value;
 	register struct adata *ap = (struct adata*)data;
+	register Namfun_t *fp;
 	if(strchr(np->nvname,'.'))
 		return;
 	ap->tp = 0;
+	/* values computed on each access cannot be cached by sh_envgen() */
+	if(nv_isref(np) || nv_isattr(np,NV_DOUBLE)==NV_DOUBLE)
+		ap->dynamic = 1;
+	for(fp=np->nvfun; fp; fp=fp->next)
+		if(fp->disc && (fp->disc->getval || fp->disc->getnum))
+			ap->dynamic = 1;
 	if(nv_isattr(np,NV_IMPORT) && np->nvenv)
 		*ap->argnam++ = np->nvenv;
 	else if(value=nv_getval(np))
 		*ap->argnam++ = staknam(np,value);
 }
 
+/*
+ * The last environment list generated, kept in one malloc'd block until
+ * an exported variable changes (see env_change()) or the scope changes.
+ */
+static struct
+{
+	char		**list;
+	Dt_t		*tree;
+	uint32_t	serial;
+} envcache;
+
 /*
  * Generate the environment list for the child.
+ * Like the original list on the stack, the cached one has two free slots
+ * before the first element for path_spawn().
  */
 char **sh_envgen(void)
 {
 	register char **er;
 	register int namec;
 	register char *cp;
+	register size_t size;
+	char **ep;
 	struct adata data;
+	/* L_ARGNOD gets generated automatically as full path name of command */
+	if(nv_isattr(L_ARGNOD,NV_EXPORT))
+	{
+		nv_offattr(L_ARGNOD,NV_EXPORT);
+		env_change();
+	}
+	if(envcache.list && envcache.serial==ast.env_serial && envcache.tree==sh.var_tree)
+		return(envcache.list);
+	if(envcache.list)
+	{
+		free((void*)(envcache.list-2));
+		envcache.list = 0;
+	}
 	data.tp = 0;
 	data.mapname = 0;
-	/* L_ARGNOD gets generated automatically as full path name of command */
-	nv_offattr(L_ARGNOD,NV_EXPORT);
+	data.dynamic = 0;
 	namec = nv_scan(sh.var_tree,nullscan,(void*)0,NV_EXPORT,NV_EXPORT);
 	namec += sh.nenv;
 	er = (char**)stakalloc((namec+4)*sizeof(char*));
@@ -2141,7 +2191,23 @@ char **sh_envgen(void)
 		memcpy((void*)er,environ,sh.nenv*sizeof(char*));
 	nv_scan(sh.var_tree, pushnam,&data,NV_EXPORT, NV_EXPORT);
 	*data.argnam = 0;
-	return(er);
+	if(data.dynamic)
+		return(er);
+	namec = data.argnam - er;
+	for(size=0, ep=er; *ep; ep++)
+		size += strlen(*ep)+1;
+	ep = (char**)sh_malloc((namec+3)*sizeof(char*)+size) + 2;
+	cp = (char*)(ep+namec+1);
+	for(namec=0; er[namec]; namec++)
+	{
+		ep[namec] = cp;
+		cp = strcopy(cp,er[namec])+1;
+	}
+	ep[namec] = 0;
+	envcache.list = ep;
+	envcache.tree = sh.var_tree;
+	envcache.serial = ast.env_serial;
+	return(ep);
 }
 
 struct scan
@@ -2241,6 +2307,7 @@ void sh_scope(struct argnod *envlist, int fun)
 		newroot = nv_dict(sh.namespace);
 #endif /* SHOPT_NAMESPACE */
 	newscope = dtopen(&_Nvdisc,Dtoset);
+	env_change();
 	if(envlist)
 	{
 		dtview(newscope,(Dt_t*)sh.var_tree);
@@ -3453,6 +3520,7 @@ void sh_unscope(void)
 		}
 		sh.var_tree=dp;
 		dtclose(root);
+		env_change();
 	}
 }
 
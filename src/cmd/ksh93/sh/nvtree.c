@@ -459,10 +459,10 @@ void nv_attribute(register Namval_t *np,Sfio_t *out,char *prefix,int noname)
 					char **xp=0;
 					if(ap && array_assoc(ap))
 					{
-						if(tp->sh_name[1]!='A')
+						if(tp->sh_name[1]!=(ap->fun==nv_hashassoc?'U':'A'))
 							continue;
 					}
-					else if(tp->sh_name[1]=='A')
+					else if(tp->sh_name[1]=='A' || tp->sh_name[1]=='U')
 						continue;
 					if((ap && (ap->nelem&ARRAY_TREE)) || (!ap && nv_isattr(np,NV_NOFREE)))
 					{
@@ -387,6 +387,8 @@ void	*sh_parse(Sfio_t *iop, int flag)
 	sh.st.staklist = 0;
 	lexp->assignlevel = 0;
 	lexp->noreserv = 0;
+	lexp->aliased = 0;
+	lexp->dcltype = 0;
 	lexp->heredoc = 0;
 	lexp->inlineno = sh.inlineno;
 	lexp->firstline = sh.st.firstline;
@@ -1109,6 +1111,7 @@ static struct argnod *assign(Lex_t *lexp, register struct argnod *ap, int type)
 			dcl_recursion = save_recursion;
 			if(p && (np=nv_search(lexp->arg->argval,sh.fun_tree,0)) && nv_isattr(np,BLT_DCL))
 			{
+				lexp->dcltype = 1;
 				lexp->token = n;
 				lexp->arg = arg;
 				array = 0;
@@ -1273,6 +1276,26 @@ static Shnode_t	*item(Lex_t *lexp,int flag)
 			t = arithfor(lexp,t);
 			break;
 		}
+		t->for_.forpar = 0;
+		/* 'for -P jobs [-k] name' runs the loop body in parallel */
+		while(!(t->for_.fortyp&COMSCAN) && lexp->arg->argval[0]=='-')
+		{
+			if(strcmp(lexp->arg->argval,"-P")==0 && !t->for_.forpar)
+			{
+				if(sh_lex(lexp))
+					sh_syntax(lexp);
+				t->for_.forpar = lexp->arg;
+				t->for_.fortyp |= FPARFOR;
+			}
+			else if(strcmp(lexp->arg->argval,"-k")==0)
+				t->for_.fortyp |= FKEEP;
+			else
+				sh_syntax(lexp);
+			if(sh_lex(lexp))
+				sh_syntax(lexp);
+		}
+		if((t->for_.fortyp&FKEEP) && !t->for_.forpar)
+			sh_syntax(lexp);
 		t->for_.fornam=(char*) lexp->arg->argval;
 		t->for_.fortyp |= FLINENO;
 #if SHOPT_KIA
@@ -1533,6 +1556,8 @@ static Shnode_t *simple(Lex_t *lexp,int flag, struct ionod *io)
 							lexp->intypeset = 1;
 						else if(np == SYSENUM)
 							lexp->intypeset = 2;
+						else if(funptr(np)!=b_readonly && funptr(np)!=b_true)
+							lexp->dcltype = 1;	/* user-defined type or declaration built-in */
 						key_on = 1;
 					}
 					else if(np==SYSCOMMAND)	/* treat 'command typeset', etc. as declaration command */
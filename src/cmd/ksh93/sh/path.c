@@ -26,6 +26,8 @@
 #include	"defs.h"
 #include	<fcin.h>
 #include	<ls.h>
+#include	<tmx.h>
+#include	<ast_dir.h>
 #include	<nval.h>
 #include	"variables.h"
 #include	"path.h"
@@ -33,11 +35,47 @@
 #include	"jobs.h"
 #include	"history.h"
 #include	"test.h"
+#include	"shnodes.h"
 #include	"FEATURE/dynamic"
 #include	"FEATURE/externs"
 
 #define RW_ALL	(S_IRUSR|S_IRGRP|S_IROTH|S_IWUSR|S_IWGRP|S_IWOTH)
 #define LIBCMD	"cmd"
+#define PATH_RACY	2	/* seconds a directory must be unmodified for a snapshot */
+
+/*
+ * A snapshot of the names in an absolute PATH directory is taken the first
+ * time a command is not found in it. As long as the directory's device,
+ * inode and modification time are unchanged, later searches look the name
+ * up in the snapshot instead of trying to stat(2) a file that does not exist,
+ * so a miss costs a stat(2) of the directory, which network file systems
+ * can answer from their attribute cache.
+ */
+struct pathdir
+{
+	Dt_t		*names;		/* names in the directory */
+	dev_t		dev;
+	ino_t		ino;
+	Time_t		mtime;
+};
+
+struct pathname
+{
+	Dtlink_t	link;
+	char		name[1];
+};
+
+static void pathname_free(Dt_t *dt, void *obj, Dtdisc_t *disc)
+{
+	NOT_USED(dt);
+	NOT_USED(disc);
+	free(obj);
+}
+
+static Dtdisc_t	_Pathdisc =
+{
+	offsetof(struct pathname,name), 0, offsetof(struct pathname,link), 0, pathname_free
+};
 
 
 static int		canexecute(char*,int);
@@ -46,6 +84,7 @@ static void noreturn	exscript(char*, char*[], char**);
 static int		checkdotpaths(Pathcomp_t*,Pathcomp_t*,Pathcomp_t*,int);
 static void		checkdup(register Pathcomp_t*);
 static Pathcomp_t	*defpathinit(void);
+static void		dirfree(Pathcomp_t*);
 
 static const char *std_path(void)
 {
@@ -82,7 +121,7 @@ static pid_t _spawnveg(const char *path, char* const argv[], char* const envp[],
 	while(1)
 	{
 		sh_stats(STAT_SPAWN);
-		pid = spawnveg(path,argv,envp,pgid,job.jobcontrol?job.fd:-1);
+		pid = spawnvefd(path,argv,envp,pgid,job.jobcontrol?job.fd:-1,sh.spawnfds);
 		if(pid>=0 || errno!=EAGAIN)
 			break;
 	}
@@ -100,10 +139,26 @@ static pid_t _spawnveg(const char *path, char* const argv[], char* const envp[],
  * _arg_extrabytes test in features/externs, but path_spawn() will increase arg_extra and retry if E2BIG still occurs.
  */
 static unsigned arg_extra = _arg_extrabytes;
+/*
+ * wait for one of the running command -x -P invocations in <pids> and free its slot
+ * the number of invocations still running is returned
+ */
+static int xargs_wait(pid_t *pids, int jobs, int running, int *exitval)
+{
+	register int i = job_waitany(pids,jobs);
+	if(i<0)
+		return(0);
+	pids[i] = 0;
+	if(sh.exitval > *exitval)
+		*exitval = sh.exitval;
+	return(running-1);
+}
+
 /*
  * used with command -x to run the command in multiple passes
  * spawn is non-zero when invoked via spawn
  * the exitval is set to the maximum for each execution
+ * with command -x -P, up to sh.xargjobs passes run at the same time
  */
 static pid_t command_xargs(const char *path, char *argv[],char *const envp[], int spawn)
 {
@@ -111,8 +166,8 @@ static pid_t command_xargs(const char *path, char *argv[],char *const envp[], in
 	char **avlast= &argv[sh.xargmax], **saveargs=0;
 	char *const *ev;
 	ssize_t size, left;
-	int nlast=1,n,exitval=0;
-	pid_t pid;
+	int nlast=1,n,i,exitval=0,jobs=0,per=0,running=0,err;
+	pid_t pid, *pids=0;
 	if(sh.xargmin < 0)
 		abort();
 	/* get env/args buffer size (may change dynamically on Linux) */
@@ -136,13 +191,28 @@ static pid_t command_xargs(const char *path, char *argv[],char *const envp[], in
 		return(-2);
 	}
 	av =  &argv[sh.xargmin];
+	if(sh.xargjobs > 1 && (n = avlast-av) > 1)
+	{
+		/* divide the arguments over at least as many passes as there are jobs */
+		jobs = sh.xargjobs < n ? sh.xargjobs : n;
+		per = (n + jobs - 1) / jobs;
+		pids = (pid_t*)stkalloc(sh.stk,jobs*sizeof(pid_t));
+		memset(pids,0,jobs*sizeof(pid_t));
+	}
 	if(!spawn)
 		job_clear();
+	else if(job.toclear)
+	{
+		/* as in _sh_fork(), drop the jobs of the parent shell before posting any passes */
+		int waitall = job.waitall;
+		job_clear();
+		job.waitall = waitall;
+	}
 	sh.exitval = 0;
 	while(av<avlast)
 	{
 		/* for each argument, account for terminating zero and possible extra bytes */
-		for(xv=av,left=size; left>0 && av<avlast;)
+		for(xv=av,left=size; left>0 && av<avlast && (!per || av-xv < per);)
 			left -= strlen(*av++) + 1 + arg_extra;
 		/* leave at least two for last */
 		if(left<0 && (avlast-av)<2)
@@ -162,21 +232,36 @@ static pid_t command_xargs(const char *path, char *argv[],char *const envp[], in
 				argv[n++] = cp;
 			argv[n] = 0;
 		}
-		if(saveargs || av<avlast || (exitval && !spawn))
+		if(saveargs || av<avlast || (exitval && !spawn) || (pids && !spawn))
 		{
+			while(running >= jobs && running)
+				running = xargs_wait(pids,jobs,running,&exitval);
 			if((pid=_spawnveg(path,argv,envp,0)) < 0)
 			{
+				err = errno;
 				if(saveargs)
 				{
 					memcpy(av,saveargs,n);
 					free(saveargs);
 				}
+				while(running)
+					running = xargs_wait(pids,jobs,running,&exitval);
+				errno = err;
 				return(-1);
 			}
 			job_post(pid,0);
-			job_wait(pid);
-			if(sh.exitval>exitval)
-				exitval = sh.exitval;
+			if(pids)
+			{
+				for(i=0; pids[i]; i++);
+				pids[i] = pid;
+				running++;
+			}
+			else
+			{
+				job_wait(pid);
+				if(sh.exitval>exitval)
+					exitval = sh.exitval;
+			}
 			if(saveargs)
 			{
 				memcpy(av,saveargs,n);
@@ -186,12 +271,23 @@ static pid_t command_xargs(const char *path, char *argv[],char *const envp[], in
 		}
 		else if(spawn)
 		{
-			sh.xargexit = exitval;
-			return(_spawnveg(path,argv,envp,spawn>>1));
+			/* the caller posts and waits for the last pass; the others must be done when it returns */
+			while(running >= jobs && running)
+				running = xargs_wait(pids,jobs,running,&exitval);
+			pid = _spawnveg(path,argv,envp,spawn>>1);
+			err = errno;
+			while(running)
+				running = xargs_wait(pids,jobs,running,&exitval);
+			if(pid > 0)
+				sh.xargexit = exitval;
+			errno = err;
+			return(pid);
 		}
 		else
 			return(execve(path,argv,envp));
 	}
+	while(running)
+		running = xargs_wait(pids,jobs,running,&exitval);
 	if(!spawn)
 		exit(exitval);
 	return(-1);
@@ -266,6 +362,7 @@ void  path_delete(Pathcomp_t *first)
 				free((void*)pp->lib);
 			if(pp->bbuf)
 				free((void*)pp->bbuf);
+			dirfree(pp);
 			free((void*)pp);
 			if(old)
 				old->next = ppnext;
@@ -585,6 +682,7 @@ static void funload(int fno, const char *name)
 	sh.funload = 1;
 	sh.inlineno = 1;
 	error_info.line = 0;
+	fno = sh_pcopen(fno);
 	sh_eval(sfnew(NIL(Sfio_t*),buff,IOBSIZE,fno,SF_READ),SH_FUNEVAL);
 	sh_close(fno);
 	sh.readscript = 0;
@@ -711,6 +809,73 @@ int	path_search(register const char *name,Pathcomp_t **oldpp, int flag)
 	return(0);
 }
 
+/*
+ * free the directory snapshot of <pp>
+ */
+static void dirfree(Pathcomp_t *pp)
+{
+	if(pp->dir)
+	{
+		dtclose(pp->dir->names);
+		free((void*)pp->dir);
+		pp->dir = 0;
+	}
+}
+
+#if !_WINIX
+/*
+ * returns 0 if the snapshot of the directory of <pp> is current and does not contain <name>
+ */
+static int dirhas(Pathcomp_t *pp, const char *name)
+{
+	register struct pathdir *dp = pp->dir;
+	struct stat statb;
+	if(!dp || strchr(name,'/'))
+		return(1);
+	if(stat(pp->name,&statb)<0 || statb.st_dev!=dp->dev || statb.st_ino!=dp->ino || tmxgetmtime(&statb)!=dp->mtime)
+	{
+		dirfree(pp);
+		return(1);
+	}
+	return(dtmatch(dp->names,(void*)name)!=0);
+}
+
+/*
+ * take a snapshot of the names in the directory of <pp>
+ * a directory modified in the last PATH_RACY seconds may still get names
+ * with the same time stamp, so it is not taken then
+ */
+static void dirsnap(Pathcomp_t *pp)
+{
+	register struct pathdir *dp;
+	register struct pathname *np;
+	register struct dirent *ep;
+	DIR *dir;
+	struct stat statb;
+	size_t n;
+	if(pp->dir || *pp->name!='/' || stat(pp->name,&statb)<0)
+		return;
+	if(tmxgetmtime(&statb) > tmxgettime()-(Time_t)PATH_RACY*1000000000)
+		return;
+	if(!(dir = opendir(pp->name)))
+		return;
+	dp = sh_newof(0,struct pathdir,1,0);
+	dp->names = dtopen(&_Pathdisc,Dtset);
+	dp->dev = statb.st_dev;
+	dp->ino = statb.st_ino;
+	dp->mtime = tmxgetmtime(&statb);
+	while(ep = readdir(dir))
+	{
+		n = strlen(ep->d_name);
+		np = (struct pathname*)sh_malloc(sizeof(struct pathname)+n);
+		memcpy(np->name,ep->d_name,n+1);
+		dtinsert(dp->names,np);
+	}
+	closedir(dir);
+	pp->dir = dp;
+}
+#endif /* !_WINIX */
+
 /*
  * do a path search and find the full pathname of file name
  *
@@ -835,7 +1000,20 @@ Pathcomp_t *path_absolute(register const char *name, Pathcomp_t *pp, int flag)
 		}
 		sh.bltin_dir = 0;
 		sh_stats(STAT_PATHS);
+#if _WINIX
 		f = canexecute(stakptr(PATH_OFFSET),isfun);
+#else
+		if(!isfun && !dirhas(oldpp,name))
+		{
+			f = -1;
+			errno = ENOENT;
+		}
+		else if((f = canexecute(stakptr(PATH_OFFSET),isfun))<0 && errno==ENOENT && !isfun)
+		{
+			dirsnap(oldpp);
+			errno = ENOENT;
+		}
+#endif /* _WINIX */
 		if(isfun && f>=0 && (cp = strrchr(name,'.')))
 		{
 			*cp = 0;
@@ -1194,7 +1372,13 @@ pid_t path_spawn(const char *opath,register char **argv, char **envp, Pathcomp_t
 	}
 	else
 #endif
-	if(spawn)
+	if(sh_isstate(SH_XARG) && sh.xargjobs>1 && sh.xargmin>0 && sh.xargmax>sh.xargmin)
+	{
+		/* command -x -P: divide the arguments over parallel passes right away */
+		pid = -1;
+		errno = E2BIG;
+	}
+	else if(spawn)
 		pid = _spawnveg(opath, &argv[0], envp, spawn>>1);
 	else
 		pid = execve(opath, &argv[0], envp);
@@ -1701,7 +1885,10 @@ void path_newdir(Pathcomp_t *first)
 		{
 			pp->next = next->next;
 			if(--next->refcount<=0)
+			{
+				dirfree(next);
 				free((void*)next);
+			}
 		}
 		if(stat(pp->name,&statb)<0 || !S_ISDIR(statb.st_mode))
 		{
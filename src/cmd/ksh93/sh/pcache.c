@@ -0,0 +1,200 @@
+/***********************************************************************
+*                                                                      *
+*              This file is part of the ksh 93u+m package              *
+*             Copyright (c) 2022 Contributors to ksh 93u+m             *
+*                    <https://github.com/ksh93/ksh>                    *
+*                      and is licensed under the                       *
+*                 Eclipse Public License, Version 2.0                  *
+*                                                                      *
+*                A copy of the License is available at                 *
+*      https://www.eclipse.org/org/documents/epl-2.0/EPL-2.0.html      *
+*         (with md5 checksum 84283fa8859daf213bdda5a9f8d1be1d)         *
+*                                                                      *
+***********************************************************************/
+/*
+ * On-disk parse tree cache for dot scripts and autoloaded functions
+ *
+ * If the KSH_CACHEDIR variable names a directory, the parse trees of
+ * files read by the '.' and 'source' commands or loaded from FPATH are
+ * stored there in the shcomp(1) intermediate code format (see tdump.c)
+ * and restored on later reads (see trestore.c) instead of being parsed.
+ *
+ * A cache file is named after the device and inode numbers of the script
+ * and only used if the size and modification time recorded in its header
+ * still match the script, it was written by the same bytecode version and
+ * with the same parser-relevant shell options, and it is owned by the
+ * effective user ID and not writable by anyone else. Parses that expanded
+ * user-defined aliases or used types or declaration built-ins not defined
+ * by the script itself are never cached, as the result depends on them.
+ * New cache files are written under a temporary name and renamed into
+ * place only once the entire script has been parsed.
+ */
+
+#include	"shopt.h"
+#include	"defs.h"
+#include	<tmx.h>
+#include	"variables.h"
+#include	"shlex.h"
+#include	"shnodes.h"
+#include	"io.h"
+#include	"version.h"
+
+#define CNTL(x)		((x)&037)
+
+/* header of a cache file, followed by the shcomp header and the parse trees */
+struct pchdr
+{
+	char		magic[4];
+	unsigned int	version;	/* SHCOMP_HDR_VERSION */
+	unsigned int	flags;		/* parser-relevant options, see pcflags() */
+	dev_t		dev;		/* device of the script */
+	ino_t		ino;		/* inode of the script */
+	off_t		size;		/* size of the script */
+	Time_t		mtime;		/* modification time of the script */
+};
+
+/* a cache file being written, as passed to sh_eval() via sh.pcache */
+struct pcache
+{
+	Sfio_t		*out;		/* stream for temporary cache file */
+	unsigned int	flags;		/* pcflags() at start of parse */
+	char		*tmpname;	/* name of temporary cache file */
+	char		name[1];	/* name of cache file */
+};
+
+static const char pcmagic[4] = { CNTL('k'),'s','h','c' };
+static const char shcomp_header[6] = { CNTL('k'),CNTL('s'),CNTL('h'),0,SHCOMP_HDR_VERSION,0 };
+
+/*
+ * return the shell options that influence the parser
+ */
+static unsigned int pcflags(void)
+{
+	unsigned int flags = 0;
+	if(sh_isoption(SH_POSIX))
+		flags |= 1;
+	if(sh_isoption(SH_BRACEEXPAND))
+		flags |= 2;
+	if(sh_isoption(SH_KEYWORD))
+		flags |= 4;
+	if(sh_isoption(SH_RESTRICTED))
+		flags |= 8;
+	return(flags);
+}
+
+/*
+ * move <fd> out of the way of user file descriptors and set close-on-exec
+ */
+static int pcfd(int fd)
+{
+	if(fd>=0 && (fd = sh_iomovefd(fd)) > 0)
+	{
+		fcntl(fd,F_SETFD,FD_CLOEXEC);
+		sh.fdstatus[fd] |= IOCLEX;
+	}
+	return(fd);
+}
+
+/*
+ * Consult the parse tree cache for the script open for reading on <fd>.
+ * If the cache holds a valid parse tree for it, <fd> is closed and a
+ * file descriptor for the cached parse tree is returned. Otherwise, <fd>
+ * is returned and, if possible, a new cache file is prepared that the
+ * next call to sh_eval() will write the parse trees to.
+ */
+int sh_pcopen(int fd)
+{
+	Namval_t	*np;
+	char		*dir, *name;
+	struct stat	statb, cstatb;
+	struct pchdr	hdr;
+	struct pcache	*pc;
+	int		cfd;
+	Sfio_t		*out;
+	if(sh.pcache || sh_isoption(SH_NOEXEC) || !(np = nv_open("KSH_CACHEDIR",sh.var_tree,NV_NOADD)) || !(dir = nv_getval(np)) || *dir!='/')
+		return(fd);
+	if(fstat(fd,&statb)<0 || !S_ISREG(statb.st_mode))
+		return(fd);
+	sfprintf(sh.strbuf,"%s/%jx.%jx",dir,(uintmax_t)statb.st_dev,(uintmax_t)statb.st_ino);
+	name = sfstruse(sh.strbuf);
+	if((cfd = pcfd(sh_open(name,O_RDONLY,0))) >= 0)
+	{
+		if(fstat(cfd,&cstatb)>=0 && S_ISREG(cstatb.st_mode)
+		&& cstatb.st_uid==sh.euserid && !(cstatb.st_mode&(S_IWGRP|S_IWOTH))
+		&& read(cfd,&hdr,sizeof(hdr))==sizeof(hdr)
+		&& memcmp(hdr.magic,pcmagic,sizeof(pcmagic))==0
+		&& hdr.version==SHCOMP_HDR_VERSION
+		&& hdr.flags==pcflags()
+		&& hdr.dev==statb.st_dev && hdr.ino==statb.st_ino
+		&& hdr.size==statb.st_size && hdr.mtime==tmxgetmtime(&statb))
+		{
+			sh_close(fd);
+			return(cfd);
+		}
+		sh_close(cfd);
+	}
+	/* cache miss; prepare a new cache file */
+	pc = sh_malloc(sizeof(struct pcache)+2*strlen(name)+16);
+	strcpy(pc->name,name);
+	pc->tmpname = pc->name+strlen(name)+1;
+	sfsprintf(pc->tmpname,strlen(name)+15,"%s.%u",name,(unsigned int)sh.current_pid);
+	if((cfd = pcfd(sh_open(pc->tmpname,O_WRONLY|O_CREAT|O_EXCL,S_IRUSR|S_IWUSR))) < 0)
+	{
+		free(pc);
+		return(fd);
+	}
+	memset(&hdr,0,sizeof(hdr));
+	memcpy(hdr.magic,pcmagic,sizeof(pcmagic));
+	hdr.version = SHCOMP_HDR_VERSION;
+	hdr.flags = pc->flags = pcflags();
+	hdr.dev = statb.st_dev;
+	hdr.ino = statb.st_ino;
+	hdr.size = statb.st_size;
+	hdr.mtime = tmxgetmtime(&statb);
+	if(!(out = sfnew(NIL(Sfio_t*),NIL(char*),SF_UNBOUND,cfd,SF_WRITE)))
+	{
+		sh_close(cfd);
+		unlink(pc->tmpname);
+		free(pc);
+		return(fd);
+	}
+	sfwrite(out,&hdr,sizeof(hdr));
+	sfwrite(out,shcomp_header,sizeof(shcomp_header));
+	pc->out = out;
+	sh.pcache = pc;
+	return(fd);
+}
+
+/*
+ * Write parse tree <t> to cache file <pc>. Returns 0 on success.
+ * On failure, the cache file is discarded and -1 is returned.
+ */
+int sh_pcdump(void *pc, const Shnode_t *t)
+{
+	struct pcache *pp = (struct pcache*)pc;
+	Lex_t *lexp = (Lex_t*)sh.lex_context;
+	if(lexp->aliased || lexp->dcltype || pp->flags!=pcflags() || sh_tdump(pp->out,t)<0)
+	{
+		sh_pcclose(pc,0);
+		return(-1);
+	}
+	return(0);
+}
+
+/*
+ * Close cache file <pc>. If <commit> is set and no error occurred,
+ * it is renamed into place, otherwise it is removed.
+ */
+void sh_pcclose(void *pc, int commit)
+{
+	struct pcache *pp = (struct pcache*)pc;
+	int fd = sffileno(pp->out);
+	if(sfsync(pp->out)<0 || sferror(pp->out))
+		commit = 0;
+	sfsetfd(pp->out,-1);
+	sfclose(pp->out);
+	sh_close(fd);
+	if(!commit || rename(pp->tmpname,pp->name)<0)
+		unlink(pp->tmpname);
+	free(pc);
+}
@@ -0,0 +1,387 @@
+/***********************************************************************
+*                                                                      *
+*              This file is part of the ksh 93u+m package              *
+*             Copyright (c) 2022 Contributors to ksh 93u+m             *
+*                    <https://github.com/ksh93/ksh>                    *
+*                      and is licensed under the                       *
+*                 Eclipse Public License, Version 2.0                  *
+*                                                                      *
+*                A copy of the License is available at                 *
+*      https://www.eclipse.org/org/documents/epl-2.0/EPL-2.0.html      *
+*         (with md5 checksum 84283fa8859daf213bdda5a9f8d1be1d)         *
+*                                                                      *
+***********************************************************************/
+/*
+ * Per-command profiler for 'set -o profile'
+ *
+ * While the option is on, sh_exec() calls sh_profcmd() before each simple
+ * command, ((...)) and [[ ... ]] command, and sh_funct() calls
+ * sh_profenter() and sh_profleave() around each function call. The elapsed
+ * time, the CPU time of the shell and its waited-for children, and the
+ * numbers of processes started and of memory allocations since the previous
+ * call are charged to the command that was running, identified by its line
+ * number and the stack of function calls leading to it.
+ *
+ * On exit, sh_profend() writes a flat profile by command and a call graph
+ * by function to the file named by KSH_PROFILE, or to standard error if that
+ * is unset or empty. The time charged to each call stack is also written to
+ * $KSH_PROFILE.folded in the "folded stacks" format read by flame graph
+ * tools. Forked subshells are not profiled; their time is charged to the
+ * command that waited for them.
+ */
+
+#include	"shopt.h"
+#include	"defs.h"
+#include	<tmx.h>
+#include	"io.h"
+#include	"FEATURE/time"
+
+#if SHOPT_STATS
+
+#if _lib_getrusage && !defined(RUSAGE_SELF)
+#   include <sys/resource.h>
+#endif
+
+#define PROFMAIN	"main"		/* name of the outermost frame */
+#define tvtons(tv)	((Time_t)(tv).tv_sec*1000000000+(Time_t)(tv).tv_usec*1000)
+
+/* counters for a command in a call stack, a function or a call site */
+struct profrec
+{
+	Dtlink_t	link;
+	unsigned long	count;		/* times executed or called */
+	unsigned long	forks;		/* processes started */
+	unsigned long	allocs;		/* sh_*alloc() calls */
+	Time_t		wall;		/* elapsed time in nanoseconds */
+	Time_t		cpu;		/* CPU time in nanoseconds */
+	char		name[1];	/* key */
+};
+
+/* a function call in progress */
+struct profframe
+{
+	char		*stack;		/* function names separated by ';' */
+	struct profrec	*caller;	/* command that called the function */
+	int		level;		/* function and dot script depth of the caller */
+};
+
+struct profile
+{
+	Dt_t		*cmds;		/* by "stack:line" */
+	Dt_t		*funs;		/* by function name */
+	Dt_t		*calls;		/* by "function caller:line" */
+	struct profrec	*cur;		/* command being charged */
+	struct profframe *frames;
+	int		nframes;
+	int		maxframes;
+	Time_t		wall;		/* values at start of current charge */
+	Time_t		cpu;
+	unsigned long	forks;
+	unsigned long	allocs;
+};
+
+static Dtdisc_t	_Profdisc =
+{
+	offsetof(struct profrec,name), 0, offsetof(struct profrec,link)
+};
+
+static Time_t cputime(void)
+{
+#if _lib_getrusage
+	struct rusage	self, child;
+	getrusage(RUSAGE_SELF,&self);
+	getrusage(RUSAGE_CHILDREN,&child);
+	return(tvtons(self.ru_utime)+tvtons(self.ru_stime)+tvtons(child.ru_utime)+tvtons(child.ru_stime));
+#else
+	struct tms	tms;
+	times(&tms);
+	return((Time_t)(tms.tms_utime+tms.tms_stime+tms.tms_cutime+tms.tms_cstime)*1000000000/sh.lim.clk_tck);
+#endif
+}
+
+#define nforks()	((unsigned long)sh.stats[STAT_FORKS]+sh.stats[STAT_SPAWN])
+
+/*
+ * start a new charge; called last so that the profiler's own allocations are not counted
+ */
+static void mark(register struct profile *pp)
+{
+	pp->forks = nforks();
+	pp->allocs = sh.nalloc;
+}
+
+/*
+ * charge the resources used since the last call to the current command
+ */
+static void charge(register struct profile *pp)
+{
+	register struct profrec	*rp;
+	Time_t			wall = tmxgettime(), cpu = cputime();
+	if(rp = pp->cur)
+	{
+		rp->wall += wall - pp->wall;
+		rp->cpu += cpu - pp->cpu;
+		rp->forks += nforks() - pp->forks;
+		rp->allocs += sh.nalloc - pp->allocs;
+	}
+	pp->wall = wall;
+	pp->cpu = cpu;
+}
+
+static struct profrec *profrec(Dt_t *dict, const char *name)
+{
+	register struct profrec	*rp;
+	if(!(rp = (struct profrec*)dtmatch(dict,name)))
+	{
+		rp = (struct profrec*)sh_calloc(1,sizeof(struct profrec)+strlen(name));
+		strcpy(rp->name,name);
+		dtinsert(dict,rp);
+	}
+	return(rp);
+}
+
+static struct profile *profopen(void)
+{
+	register struct profile	*pp;
+	if(pp = (struct profile*)sh.profile)
+		return(pp);
+	pp = sh_newof(0,struct profile,1,0);
+	pp->cmds = dtopen(&_Profdisc,Dtset);
+	pp->funs = dtopen(&_Profdisc,Dtset);
+	pp->calls = dtopen(&_Profdisc,Dtset);
+	pp->frames = sh_newof(0,struct profframe,pp->maxframes=16,0);
+	pp->frames[0].stack = PROFMAIN;
+	pp->frames[0].level = -1;
+	pp->nframes = 1;
+	pp->wall = tmxgettime();
+	pp->cpu = cputime();
+	sh.profile = (void*)pp;
+	return(pp);
+}
+
+/*
+ * pop the frames of calls made at or above function depth <level>;
+ * a longjmp out of a function can leave stale frames behind
+ */
+static void profpop(register struct profile *pp, int level)
+{
+	register struct profframe *fp;
+	while(pp->nframes>1 && (fp = &pp->frames[pp->nframes-1])->level >= level)
+	{
+		pp->cur = fp->caller;
+		free((void*)fp->stack);
+		pp->nframes--;
+	}
+}
+
+/* the last component of a "stack:line" name */
+static const char *leaf(const char *name)
+{
+	register const char *cp = strrchr(name,';');
+	return(cp ? cp+1 : name);
+}
+
+void sh_profcmd(int line)
+{
+	register struct profile	*pp = profopen();
+	charge(pp);
+	profpop(pp,sh.fn_depth+sh.dot_depth);
+	pp->cur = profrec(pp->cmds,sfprints("%s:%d",pp->frames[pp->nframes-1].stack,line));
+	pp->cur->count++;
+	mark(pp);
+}
+
+/*
+ * called before a function is run; returns the level to pass to sh_profleave()
+ */
+int sh_profenter(const char *name)
+{
+	register struct profile	*pp = profopen();
+	register struct profframe *fp;
+	int			level = sh.fn_depth+sh.dot_depth;
+	charge(pp);
+	profpop(pp,level);
+	if(pp->nframes >= pp->maxframes)
+		pp->frames = sh_newof(pp->frames,struct profframe,pp->maxframes*=2,0);
+	fp = &pp->frames[pp->nframes++];
+	fp->stack = sh_strdup(sfprints("%s;%s",fp[-1].stack,name));
+	fp->caller = pp->cur;
+	fp->level = level;
+	profrec(pp->funs,name)->count++;
+	profrec(pp->calls,sfprints("%s %s",name,pp->cur?leaf(pp->cur->name):PROFMAIN))->count++;
+	mark(pp);
+	return(level);
+}
+
+void sh_profleave(int level)
+{
+	register struct profile	*pp = (struct profile*)sh.profile;
+	if(!pp)
+		return;
+	charge(pp);
+	profpop(pp,level);
+	mark(pp);
+}
+
+/*
+ * a forked child does not profile; the parent charges the time it waits for it
+ */
+void sh_profchild(void)
+{
+	sh_offoption(SH_PROFILING);
+	sh.profile = 0;
+}
+
+static int bywall(const void *a, const void *b)
+{
+	register const struct profrec	*ra = *(struct profrec**)a, *rb = *(struct profrec**)b;
+	if(ra->wall != rb->wall)
+		return(ra->wall < rb->wall ? 1 : -1);
+	return(strcmp(ra->name,rb->name));
+}
+
+/*
+ * return the records of <dict> sorted by decreasing wall time
+ */
+static struct profrec **sorted(Dt_t *dict, int *np)
+{
+	register struct profrec	*rp, **list;
+	register int		n = 0;
+	list = (struct profrec**)sh_malloc((dtsize(dict)+1)*sizeof(struct profrec*));
+	for(rp=(struct profrec*)dtfirst(dict); rp; rp=(struct profrec*)dtnext(dict,rp))
+		list[n++] = rp;
+	qsort(list,n,sizeof(struct profrec*),bywall);
+	*np = n;
+	return(list);
+}
+
+static void add(register struct profrec *to, register const struct profrec *from)
+{
+	to->forks += from->forks;
+	to->allocs += from->allocs;
+	to->wall += from->wall;
+	to->cpu += from->cpu;
+}
+
+/*
+ * charge <rp> to each function on its call stack, once for recursive calls
+ */
+static void inclusive(register struct profile *pp, register struct profrec *rp)
+{
+	register char	*cp, *ep, *sp;
+	char		*stack = sh_strdup(rp->name);
+	*strrchr(stack,':') = 0;
+	for(cp=strchr(stack,';'); cp; cp=ep)
+	{
+		*cp++ = 0;
+		if(ep = strchr(cp,';'))
+			*ep = 0;
+		for(sp=stack+sizeof(PROFMAIN); sp<cp && strcmp(sp,cp); sp+=strlen(sp)+1)
+			;
+		if(sp>=cp)
+			add(profrec(pp->funs,cp),rp);
+		if(ep)
+			*ep = ';';
+	}
+	free((void*)stack);
+}
+
+#define secs(t)		((double)(t)/1e9)
+#define percent(t,n)	((n) ? 100.*(double)(t)/(double)(n) : 0.)
+
+static void profline(Sfio_t *out, register struct profrec *rp, const char *name, Time_t total)
+{
+	sfprintf(out,"%7.2f %12.6f %12.6f %10lu %8lu %10lu  %s\n",percent(rp->wall,total),secs(rp->wall),secs(rp->cpu),rp->count,rp->forks,rp->allocs,name);
+}
+
+static void profreport(register struct profile *pp, Sfio_t *out)
+{
+	register struct profrec	*rp, *fp, **list;
+	Dt_t			*flat = dtopen(&_Profdisc,Dtset);
+	struct profrec		total;
+	size_t			len;
+	int			i, n;
+	memset((void*)&total,0,sizeof(total));
+	for(rp=(struct profrec*)dtfirst(pp->cmds); rp; rp=(struct profrec*)dtnext(pp->cmds,rp))
+	{
+		add(&total,rp);
+		total.count += rp->count;
+		fp = profrec(flat,leaf(rp->name));
+		fp->count += rp->count;
+		add(fp,rp);
+		inclusive(pp,rp);
+	}
+	sfprintf(out,"Flat profile: self time by command\n");
+	sfprintf(out,"%7s %12s %12s %10s %8s %10s  %s\n","%time","seconds","cpu secs","count","forks","allocs","command");
+	list = sorted(flat,&n);
+	for(i=0; i < n; i++)
+		profline(out,list[i],list[i]->name,total.wall);
+	free((void*)list);
+	profline(out,&total,"total",total.wall);
+	sfprintf(out,"\nCall graph: inclusive time by function\n");
+	sfprintf(out,"%7s %12s %12s %10s %8s %10s  %s\n","%time","seconds","cpu secs","calls","forks","allocs","function");
+	list = sorted(pp->funs,&n);
+	for(i=0; i < n; i++)
+	{
+		rp = list[i];
+		profline(out,rp,rp->name,total.wall);
+		len = strlen(rp->name);
+		for(fp=(struct profrec*)dtfirst(pp->calls); fp; fp=(struct profrec*)dtnext(pp->calls,fp))
+			if(strncmp(fp->name,rp->name,len)==0 && fp->name[len]==' ')
+				sfprintf(out,"%33s %10lu %20s  called from %s\n","",fp->count,"",fp->name+len+1);
+	}
+	free((void*)list);
+	while(rp = (struct profrec*)dtfirst(flat))
+	{
+		dtdelete(flat,rp);
+		free((void*)rp);
+	}
+	dtclose(flat);
+}
+
+/*
+ * write the call stacks with their time in microseconds for flame graph tools
+ */
+static void proffolded(register struct profile *pp, Sfio_t *out)
+{
+	register struct profrec	*rp;
+	for(rp=(struct profrec*)dtfirst(pp->cmds); rp; rp=(struct profrec*)dtnext(pp->cmds,rp))
+		sfprintf(out,"%s %llu\n",rp->name,(Sfulong_t)(rp->wall/1000));
+}
+
+/*
+ * write the profile on exit
+ */
+void sh_profend(void)
+{
+	register struct profile	*pp = (struct profile*)sh.profile;
+	Namval_t		*np;
+	Sfio_t			*out = sfstderr, *folded = 0;
+	char			*file;
+	if(!pp)
+		return;
+	charge(pp);
+	sh.profile = 0;
+	if((np = nv_open("KSH_PROFILE",sh.var_tree,NV_NOADD)) && (file = nv_getval(np)) && *file)
+	{
+		if(!(out = sfopen(NIL(Sfio_t*),file,"w")))
+		{
+			errormsg(SH_DICT,ERROR_system(0),e_create,file);
+			return;
+		}
+		if(!(folded = sfopen(NIL(Sfio_t*),sfprints("%s.folded",file),"w")))
+			errormsg(SH_DICT,ERROR_system(0),e_create,sfprints("%s.folded",file));
+	}
+	profreport(pp,out);
+	if(folded)
+	{
+		proffolded(pp,folded);
+		sfclose(folded);
+	}
+	if(out==sfstderr)
+		sfsync(out);
+	else
+		sfclose(out);
+}
+
+#endif /* SHOPT_STATS */
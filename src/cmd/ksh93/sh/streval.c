@@ -237,6 +237,7 @@ Sfdouble_t	arith_exec(Arith_t *ep)
 			if(node.flag = c)
 				lastval = 0;
 			node.isfloat=0;
+			node.isint=0;
 			node.level = sh.arithrecursion;
 			node.nosub = 0;
 			num = (*ep->fun)(&ptr,&node,VALUE,num);
@@ -250,7 +251,9 @@ Sfdouble_t	arith_exec(Arith_t *ep)
 				arith_error(node.value,ptr,ep->emode);
 			*++sp = num;
 			type = node.isfloat;
-			if(num > LDBL_ULLONG_MAX || num < LDBL_LLONG_MIN)
+			if(node.isint)
+				type = 0;
+			else if(num > LDBL_ULLONG_MAX || num < LDBL_LLONG_MIN)
 				type = 1;
 			else
 			{
@@ -120,7 +120,11 @@ static int p_tree(register const Shnode_t *t)
 				return(-1);
 			if(p_string(t->for_.fornam)<0)
 				return(-1);
-			return(p_tree((Shnode_t*)t->for_.forlst));
+			if(p_tree((Shnode_t*)t->for_.forlst)<0)
+				return(-1);
+			if(t->for_.fortyp&FPARFOR)
+				return(p_arg(t->for_.forpar));
+			return(0);
 		case TSW:
 			if(sfputu(outfile,t->sw.swline)<0)
 				return(-1);
@@ -113,6 +113,9 @@ static Shnode_t *r_tree(void)
 			t->for_.fortre = r_tree();
 			t->for_.fornam = r_string();
 			t->for_.forlst = (struct comnod*)r_tree();
+			t->for_.forpar = 0;
+			if(type&FPARFOR)
+				t->for_.forpar = r_arg();
 			break;
 		case TSW:
 			t = getnode(swnod);
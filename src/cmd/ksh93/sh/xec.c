@@ -59,11 +59,16 @@
 #define _use_ntfork_tcpgrp 1
 #endif
 
+#undef _use_ntfork_pipe
+#if SHOPT_SPAWN && _lib_posix_spawn > 1
+#define _use_ntfork_pipe 1
+#endif
+
 #if _lib_nice
     extern int	nice(int);
 #endif /* _lib_nice */
 #if SHOPT_SPAWN
-    static pid_t sh_ntfork(const Shnode_t*,char*[],int*,int);
+    static pid_t sh_ntfork(const Shnode_t*,char*[],int*,int,int);
 #endif /* SHOPT_SPAWN */
 
 static void	sh_funct(Namval_t*, int, char*[], struct argnod*,int);
@@ -626,7 +631,9 @@ int sh_eval(register Sfio_t *iop, int mode)
 	volatile int traceon=0, lineno=0;
 	int binscript=sh.binscript;
 	char comsub = sh.comsub;
+	void *volatile pcache = sh.pcache;
 	io_save = iop; /* preserve correct value across longjmp */
+	sh.pcache = 0;
 	sh.binscript = 0;
 	sh.comsub = 0;
 	sh_pushcontext(buffp,SH_JMPEVAL);
@@ -641,8 +648,16 @@ int sh_eval(register Sfio_t *iop, int mode)
 				sh_offoption(SH_XTRACE);
 		}
 		t = (Shnode_t*)sh_parse(iop,(mode&(SH_READEVAL|SH_FUNEVAL))?mode&SH_FUNEVAL:SH_NL);
+		if(pcache && sh_pcdump(pcache,t) < 0)
+			pcache = 0;
 		if(!(mode&SH_FUNEVAL) || !sfreserve(iop,0,0))
 		{
+			if(pcache)
+			{
+				/* the entire script has been parsed */
+				sh_pcclose(pcache,1);
+				pcache = 0;
+			}
 			if(!(mode&SH_READEVAL))
 				sfclose(iop);
 			io_save = 0;
@@ -661,6 +676,8 @@ int sh_eval(register Sfio_t *iop, int mode)
 			break;
 	}
 	sh_popcontext(buffp);
+	if(pcache)
+		sh_pcclose(pcache,0);
 	sh.binscript = binscript;
 	sh.comsub = comsub;
 	if(traceon)
@@ -862,6 +879,365 @@ static int check_exec_optimization(int type, int execflg, int execflg2, struct i
 	return(1);
 }
 
+/*
+ * Check whether pipeline element <t> can be run to completion before the
+ * next element is started. It must be a simple command that invokes a
+ * built-in which neither runs other commands nor can write without bound.
+ */
+static int pipe_bltin(const Shnode_t *t)
+{
+	Namval_t	*np;
+	Shbltin_f	f;
+	if((t->tre.tretyp&COMMSK)!=TFORK || t->fork.forkio)
+		return(0);
+	t = t->fork.forktre;
+	if((t->tre.tretyp&COMMSK)!=TCOM || !(np = (Namval_t*)t->com.comnamp) || !nv_isattr(np,NV_BLTIN))
+		return(0);
+	/* a function by the same name overrides a regular built-in */
+	if(dtsearch(sh.fun_tree,np)!=np)
+		return(0);
+	f = funptr(np);
+	return(f==b_print || f==b_printf || f==b_pwd || f==b_test || f==b_true || f==b_false
+	|| f==b_let || f==b_whence || f==b_alias || f==b_read || f==b_getopts || f==b_umask
+#if !SHOPT_ECHOPRINT
+	|| f==B_echo
+#endif /* !SHOPT_ECHOPRINT */
+	);
+}
+
+/*
+ * Check whether pipeline <t> can be run by pipe_nofork()
+ */
+static int pipe_nofork_ok(const Shnode_t *t)
+{
+	do
+	{
+		if(!pipe_bltin(t->lst.lstlef))
+			return(0);
+		t = t->lst.lstrit;
+	}
+	while(t->tre.tretyp==TFIL);
+	return((t->tre.tretyp&COMMSK)==TSETIO && !t->fork.forkio);
+}
+
+/*
+ * Run pipeline <t> without forking. Each element but the last is run in a
+ * virtual subshell with its standard output going to an unnamed temporary
+ * file, which then becomes the standard input of the next element. As usual,
+ * the last element is run in the current environment.
+ * Only used for command substitutions, where all elements but the last would
+ * otherwise be forked; see pipe_bltin() for which elements qualify.
+ */
+static void pipe_nofork(const Shnode_t *t, int errorflg, int flags)
+{
+	struct checkpt	*buffp = (struct checkpt*)stkalloc(sh.stk,sizeof(struct checkpt));
+	Sfio_t		*iop;
+	volatile int	fd = -1;
+	int		jmpval, topfd, exitval = 0;
+	if(sh.subshell)
+		sh_subtmpfile();
+	sh_pushcontext(buffp,SH_JMPIO);
+	jmpval = sigsetjmp(buffp->buff,0);
+	if(jmpval==0)
+	{
+		while(1)
+		{
+			if(fd>=0)
+			{
+				sh_iosave(0,buffp->topfd,(char*)0);
+				sh_iorenumber(fd,0);
+				fd = -1;
+			}
+			if(t->tre.tretyp!=TFIL)
+				break;
+			if(!(iop = sftmp(0)))
+			{
+				errormsg(SH_DICT,ERROR_system(1),e_tmpcreate);
+				UNREACHABLE();
+			}
+			/* close stream, but save file descriptor */
+			fd = sffileno(iop);
+			sfsetfd(iop,-1);
+			sfclose(iop);
+			fcntl(fd,F_SETFD,FD_CLOEXEC);
+			sh.fdstatus[fd] = IOREAD|IOWRITE|IOCLEX;
+			topfd = sh.topfd;
+			sh_iosave(1,topfd,(char*)0);
+			sh_iorenumber(sh_fcntl(fd,F_DUPFD,10),1);
+			sh_subshell(t->lst.lstlef->fork.forktre,errorflg,0);
+			if(sh.exitval)
+				exitval = sh.exitval;
+			sfsync(sfstdout);
+			sh_iorestore(topfd,0);
+			lseek(fd,(off_t)0,SEEK_SET);
+			t = t->lst.lstrit;
+		}
+		sh_exec(t->fork.forktre,flags);
+	}
+	else if(fd>=0)
+		sh_close(fd);
+	sh_popcontext(buffp);
+	sh_iorestore(buffp->topfd,jmpval);
+	if(jmpval>SH_JMPIO)
+		siglongjmp(*sh.jmplist,jmpval);
+	if(sh.exitval==0 && sh_isoption(SH_PIPEFAIL))
+		sh.exitval = exitval;
+}
+
+#if _use_ntfork_pipe
+/*
+ * Return 1 if expanding $<name> in the parent shell cannot have side effects,
+ * i.e., if the variable does not exist or is a plain variable without any
+ * discipline, 0 otherwise
+ */
+static int pipe_plainvar(const char *name, size_t len)
+{
+	Namval_t	*np;
+	char		buf[64];
+	if(len >= sizeof(buf))
+		return(0);
+	memcpy(buf,name,len);
+	buf[len] = 0;
+	if(!(np = nv_open(buf,sh.var_tree,NV_NOREF|NV_NOADD|NV_VARNAME|NV_NOFAIL)))
+		return(1);
+	if(np->nvfun || nv_isref(np) || np==RANDNOD || np==SECONDS || np==LINENO || np==SH_LINENO)
+		return(0);
+	return(strncmp(nv_name(np),".sh.",4)!=0);
+}
+
+/*
+ * If pipeline element <t> is a simple command that runs an external command,
+ * return its argument list so that it can be spawned with sh_ntfork() instead
+ * of forking the shell. As the arguments are then expanded in the parent, this
+ * is only done if that cannot have side effects, i.e., if they contain no
+ * parameter expansions other than $name of plain variables and special
+ * parameters, and no command substitutions.
+ */
+static char **pipe_spawnargs(const Shnode_t *t)
+{
+	struct argnod	*argp;
+	Pathcomp_t	*pp;
+	Namval_t	*np;
+	char		**argv, *cp;
+	int		argn;
+#if !_use_ntfork_tcpgrp
+	if(job.jobcontrol)
+		return(0);
+#endif /* !_use_ntfork_tcpgrp */
+	if(sh_isstate(SH_MONITOR) && !job.jobcontrol || sh.st.trap[SH_DEBUGTRAP] || sh_isoption(SH_RESTRICTED))
+		return(0);
+#if !SHOPT_DEVFD
+	if(sh.fifo)
+		return(0);
+#endif /* !SHOPT_DEVFD */
+	if(t->fork.forkio)
+		return(0);
+	t = t->fork.forktre;
+	if((t->tre.tretyp&COMMSK)!=TCOM || t->com.comio || t->com.comset || t->com.comnamp || !t->com.comarg)
+		return(0);
+	if(t->tre.tretyp&COMSCAN)
+	{
+		if(sh_isoption(SH_NOUNSET))
+			return(0);
+		for(argp=t->com.comarg; argp; argp=argp->argnxt.ap)
+		{
+			if(strchr(cp=argp->argval,'`'))
+				return(0);
+			while(cp=strchr(cp,'$'))
+			{
+				char	*ep = ++cp;
+				if(isalpha(*cp) || *cp=='_')
+				{
+					while(isalnum(*ep) || *ep=='_')
+						ep++;
+					if(*ep=='.' || !pipe_plainvar(cp,ep-cp))
+						return(0);
+					cp = ep;
+				}
+				else if(!isdigit(*cp) && !strchr("@*#?!$-",*cp))
+					return(0);
+			}
+		}
+	}
+	argv = sh_argbuild(&argn,&t->com,0);
+	if(argn==0 || !(cp = argv[0]))
+		return(0);
+	if(strchr(cp,'/'))
+	{
+		if(nv_search(cp,sh.bltin_tree,0) || access(cp,X_OK)<0)
+			return(0);
+	}
+	else
+	{
+		/* not for functions, built-ins or path-bound built-ins */
+		if(strchr(cp,'.') || nv_search(cp,sh.fun_tree,0))
+			return(0);
+		if(!sh_isstate(SH_DEFPATH)
+		&& (np=nv_search(cp,sh.track_tree,0))
+		&& !nv_isattr(np,NV_NOALIAS)
+		&& np->nvalue.cp)
+			cp = nv_getval(np);
+		else if((pp = path_absolute(cp,NIL(Pathcomp_t*),0)) && !(pp->flags&PATH_FPATH))
+			cp = stkptr(sh.stk,PATH_OFFSET);
+		else
+			return(0);
+		if(nv_search(cp,sh.bltin_tree,0))
+			return(0);
+	}
+	sh_stats(STAT_SCMDS);
+	error_info.line = t->com.comline-sh.st.firstline;
+	if(sh_isoption(SH_XTRACE))
+		sh_trace(argv,1);
+	return(argv);
+}
+#endif /* _use_ntfork_pipe */
+
+/*
+ * State of a parallel 'for -P' loop
+ * Iterations are numbered in list order
+ */
+struct parfor
+{
+	pid_t	*pids;		/* process of each iteration, 0 once collected */
+	int	*fds;		/* output of each iteration with -k, else 0 */
+	int	max;		/* maximum number of running iterations */
+	int	running;	/* number of running iterations */
+	int	first;		/* first iteration not yet collected or flushed */
+	int	next;		/* next iteration to start */
+	int	failed;		/* last iteration with a nonzero exit status */
+	int	exitval;	/* its exit status */
+};
+
+#define PARKEEP		4	/* -k: unflushed iterations per running one */
+
+static struct parfor *parfor_init(const Shnode_t *t, int nargs)
+{
+	register struct argnod	*arg = t->for_.forpar;
+	register struct parfor	*pp;
+	char			*cp;
+	Sfdouble_t		d;
+	cp = (arg->argflag&ARG_RAW) ? arg->argval : sh_macpat(arg,0);
+	if((d = sh_arith(cp)) < 1 || d > INT_MAX)
+	{
+		errormsg(SH_DICT,ERROR_exit(1),e_number,cp);
+		UNREACHABLE();
+	}
+	pp = (struct parfor*)stkalloc(sh.stk,sizeof(struct parfor)+nargs*sizeof(pid_t));
+	memset(pp,0,sizeof(struct parfor));
+	pp->pids = (pid_t*)(pp+1);
+	if(t->tre.tretyp&FKEEP)
+		pp->fds = (int*)stkalloc(sh.stk,nargs*sizeof(int));
+	pp->max = (int)d;
+	pp->failed = -1;
+	return(pp);
+}
+
+/*
+ * Copy the saved output of an iteration to standard output
+ */
+static void parfor_flush(int fd)
+{
+	Sfio_t	*iop;
+	lseek(fd,(off_t)0,SEEK_SET);
+	if(iop = sfnew(NIL(Sfio_t*),NIL(char*),SF_UNBOUND,fd,SF_READ))
+	{
+		sfmove(iop,sfstdout,SF_UNBOUND,-1);
+		sfsetfd(iop,-1);
+		sfclose(iop);
+	}
+	sh_close(fd);
+}
+
+/*
+ * Wait for any running iteration to complete and record its exit status
+ */
+static void parfor_wait(register struct parfor *pp)
+{
+	register int	i = job_waitany(pp->pids+pp->first,pp->next-pp->first);
+	if(i<0)
+	{
+		for(i=pp->first; i < pp->next; i++)
+			pp->pids[i] = 0;
+		pp->running = 0;
+	}
+	else
+	{
+		i += pp->first;
+		pp->pids[i] = 0;
+		pp->running--;
+		if(sh.exitval && i > pp->failed)
+		{
+			pp->failed = i;
+			pp->exitval = sh.exitval;
+		}
+	}
+	for(; pp->first < pp->next && !pp->pids[pp->first]; pp->first++)
+		if(pp->fds)
+			parfor_flush(pp->fds[pp->first]);
+}
+
+/*
+ * Run one iteration of a parallel loop body in a background process,
+ * first waiting for a free slot if the maximum number is running
+ */
+static void parfor_run(register struct parfor *pp, const Shnode_t *t, int flags)
+{
+	int	fd = -1;
+	pid_t	pid;
+	while(pp->running >= pp->max || pp->fds && pp->next-pp->first >= PARKEEP*pp->max)
+		parfor_wait(pp);
+	if(pp->fds)
+	{
+		/* with -k, standard output goes to a temporary file until it is its turn */
+		Sfio_t	*iop;
+		if(!(iop = sftmp(0)))
+		{
+			errormsg(SH_DICT,ERROR_system(1),e_tmpcreate);
+			UNREACHABLE();
+		}
+		/* close stream, but save file descriptor */
+		fd = sffileno(iop);
+		sfsetfd(iop,-1);
+		sfclose(iop);
+		if((pid = sh_fcntl(fd,F_DUPFD,10)) >= 10)
+		{
+			close(fd);
+			fd = pid;
+		}
+		fcntl(fd,F_SETFD,FD_CLOEXEC);
+		sh.fdstatus[fd] = IOREAD|IOWRITE|IOCLEX;
+		pp->fds[pp->next] = fd;
+	}
+	if(sh.subshell)
+		sh_subtmpfile();
+	if(job.parent = pid = sh_fork(FAMP,NIL(int*)))
+	{
+		pp->pids[pp->next++] = pid;
+		pp->running++;
+		return;
+	}
+	/* this is the child */
+	{
+		volatile int	jmpval;
+		struct checkpt	*buffp = (struct checkpt*)stkalloc(sh.stk,sizeof(struct checkpt));
+		sh_invalidate_rand_seed();
+		sh_pushcontext(buffp,SH_JMPEXIT);
+		jmpval = sigsetjmp(buffp->buff,0);
+		if(jmpval==0)
+		{
+			sh_offstate(SH_INTERACTIVE);
+			if(fd>=0)
+				sh_iorenumber(fd,1);
+			job_clear();
+			sh_exec(t,flags|sh_state(SH_NOFORK)|sh_state(SH_FORKED));
+		}
+		sh_popcontext(buffp);
+		if(jmpval>SH_JMPEXIT)
+			siglongjmp(*sh.jmplist,jmpval);
+		sh_done(0);
+	}
+}
+
 /*
  * Main execution function: execute any type of command.
  */
@@ -918,6 +1294,7 @@ int sh_exec(register const Shnode_t *t, int flags)
 			type &= (COMMSK|COMSCAN);
 			sh_stats(STAT_SCMDS);
 			error_info.line = t->com.comline-sh.st.firstline;
+			sh_profile(error_info.line);
 			com = sh_argbuild(&argn,&(t->com),OPTIMIZE);
 			echeck = 1;
 			if(t->tre.tretyp&COMSCAN)
@@ -993,7 +1370,7 @@ int sh_exec(register const Shnode_t *t, int flags)
 					Namval_t *tp=0;
 					if(argn)
 					{
-						if(checkopt(com,'A'))
+						if(checkopt(com,'A') || checkopt(com,'U'))
 							flgs |= NV_ARRAY;
 						else if(checkopt(com,'a'))
 							flgs |= NV_IARRAY;
@@ -1503,11 +1880,25 @@ int sh_exec(register const Shnode_t *t, int flags)
 				if(com && !job.jobcontrol)
 #endif /* _use_ntfork_tcpgrp */
 				{
-					parent = sh_ntfork(t,com,&jobid,topfd);
+					parent = sh_ntfork(t,com,&jobid,topfd,0);
+					if(parent<0)
+						break;
+				}
+				else
+#if _use_ntfork_pipe
+				if(!com && (type&(FPIN|FPOU)) && !(type&(FAMP|FCOOP)) && (com = pipe_spawnargs(t)))
+				{
+					parent = sh_ntfork(t->fork.forktre,com,&jobid,topfd,type);
+					com = 0;
 					if(parent<0)
+					{
+						if(type&FPCL)
+							sh_close(sh.inpipe[0]);
 						break;
+					}
 				}
 				else
+#endif /* _use_ntfork_pipe */
 #endif /* SHOPT_SPAWN */
 					parent = sh_fork(type,&jobid);
 			}
@@ -1845,6 +2236,11 @@ int sh_exec(register const Shnode_t *t, int flags)
 			int	*exitval=0,*saveexitval = job.exitval;
 			pid_t	savepgid = job.curpgid;
 			echeck = 1;
+			if(sh.comsub && !showme && pipe_nofork_ok(t))
+			{
+				pipe_nofork(t,errorflg,flags);
+				break;
+			}
 			job.exitval = 0;
 			job.curjobid = 0;
 			if(sh.subshell)
@@ -1992,6 +2388,7 @@ int sh_exec(register const Shnode_t *t, int flags)
 			char *cp, *trap, *nullptr = 0;
 			int nameref, refresh=1;
 			char *av[5];
+			struct parfor *pp = 0;
 #if SHOPT_OPTIMIZE
 			int  jmpval = ((struct checkpt*)sh.jmplist)->mode;
 			struct checkpt *buffp = (struct checkpt*)stkalloc(sh.stk,sizeof(struct checkpt));
@@ -2015,6 +2412,8 @@ int sh_exec(register const Shnode_t *t, int flags)
 				args=sh_argbuild(&argn,tp,0);
 				nargs = argn;
 			}
+			if(t->tre.tretyp&FPARFOR)
+				pp = parfor_init(t,nargs);
 			np = nv_open(t->for_.fornam, sh.var_tree,NV_NOARRAY|NV_VARNAME|NV_NOREF);
 			nameref = nv_isref(np)!=0;
 			sh.st.loopcnt++;
@@ -2079,7 +2478,10 @@ int sh_exec(register const Shnode_t *t, int flags)
 					av[4] = 0;
 					sh_debug(trap,(char*)0,(char*)0,av,0);
 				}
-				sh_exec(t->for_.fortre,flag);
+				if(pp)
+					parfor_run(pp,t->for_.fortre,flag);
+				else
+					sh_exec(t->for_.fortre,flag);
 				flag &= ~OPTIMIZE_FLAG;
 				if(t->tre.tretyp&COMSCAN)
 				{
@@ -2093,6 +2495,13 @@ int sh_exec(register const Shnode_t *t, int flags)
 				if(sh.st.breakcnt<0)
 					sh.st.breakcnt++;
 			}
+			if(pp)
+			{
+				/* collect the remaining iterations */
+				while(pp->running)
+					parfor_wait(pp);
+				sh.exitval = pp->exitval;
+			}
 #if SHOPT_OPTIMIZE
 		endfor:
 			sh_popcontext(buffp);
@@ -2212,6 +2621,7 @@ int sh_exec(register const Shnode_t *t, int flags)
 			register char *trap;
 			char *arg[4];
 			error_info.line = t->ar.arline-sh.st.firstline;
+			sh_profile(error_info.line);
 			arg[0] = "((";
 			if(!(t->ar.arexpr->argflag&ARG_RAW))
 				arg[1] = sh_macpat(t->ar.arexpr,OPTIMIZE|ARG_ARITH);
@@ -2565,6 +2975,8 @@ int sh_exec(register const Shnode_t *t, int flags)
 			if(type&TTEST)
 				skipexitset++;
 			error_info.line = t->tst.tstline-sh.st.firstline;
+			if(type&TTEST)
+				sh_profile(error_info.line);
 			echeck = 1;
 			if((type&TPAREN)==TPAREN)
 			{
@@ -2895,6 +3307,9 @@ pid_t _sh_fork(register pid_t parent,int flags,int *jobid)
 #if SHOPT_ACCT
 	sh_accsusp();
 #endif	/* SHOPT_ACCT */
+#if SHOPT_STATS
+	sh_profchild();
+#endif /* SHOPT_STATS */
 	/* Reset remaining signals to parent */
 	/* except for those `lost' by trap   */
 	if(!(flags&FSHOWME))
@@ -3128,6 +3543,10 @@ int sh_funscope(int argn, char *argv[],int(*fun)(void*),void *arg,int execflg)
 	sh.invoc_local = save_invoc_local;
 	sh.fn_depth--;
 	update_sh_level();
+#if SHOPT_STATS
+	if(jmpval > SH_JMPFUN)	/* unwinding past sh_funct() */
+		sh_profleave(sh.fn_depth+sh.dot_depth);
+#endif /* SHOPT_STATS */
 	if(sh.fn_depth==1 && jmpval==SH_JMPERRFN)
 	{
 		errormsg(SH_DICT,ERROR_exit(1),e_toodeep,argv[0]);
@@ -3179,6 +3598,9 @@ static void sh_funct(Namval_t *np,int argn, char *argv[],struct argnod *envlist,
 	struct funenv fun;
 	char *fname = nv_getval(SH_FUNNAMENOD);
 	pid_t		pipepid = sh.pipepid;
+#if SHOPT_STATS
+	int		proflevel = sh_isoption(SH_PROFILING) ? sh_profenter(nv_name(np)) : -1;
+#endif /* SHOPT_STATS */
 #if !SHOPT_DEVFD
 	Dt_t		*save_fifo_tree = sh.fifo_tree;
 	sh.fifo_tree = NIL(Dt_t*);
@@ -3213,6 +3635,10 @@ static void sh_funct(Namval_t *np,int argn, char *argv[],struct argnod *envlist,
 		fun.nref = 0;
 		sh_funscope(argn,argv,0,&fun,execflg);
 	}
+#if SHOPT_STATS
+	if(proflevel >= 0)
+		sh_profleave(proflevel);
+#endif /* SHOPT_STATS */
 	sh.last_root = nv_dict(DOTSHNOD);
 	nv_putval(SH_FUNNAMENOD,fname,NV_NOFREE);
 	nv_putval(SH_PATHNAMENOD,sh.st.filename,NV_NOFREE);
@@ -3357,9 +3783,10 @@ static void sigreset(int mode)
  * Incompatible with job control on interactive shells (job.jobcontrol) if
  * the system does not support posix_spawn_file_actions_addtcsetpgrp_np().
  */
-static pid_t sh_ntfork(const Shnode_t *t,char *argv[],int *jobid,int topfd)
+static pid_t sh_ntfork(const Shnode_t *t,char *argv[],int *jobid,int topfd,int type)
 {
 	static pid_t	spawnpid;
+	int		fdops[11], *fp = fdops;
 	struct checkpt	*buffp = (struct checkpt*)stkalloc(sh.stk,sizeof(struct checkpt));
 	int		jmpval,jobfork=0;
 	volatile int	scope=0, sigwasset=0;
@@ -3446,6 +3873,26 @@ static pid_t sh_ntfork(const Shnode_t *t,char *argv[],int *jobid,int topfd)
 		sigwasset++;
 	        /* find first path that has a library component */
 		for(pp=path_get(argv[0]); pp && !pp->lib ; pp=pp->next);
+		/* let the new process connect to the pipeline and close the shell's pipe ends */
+		if(type&FPIN)
+		{
+			*fp++ = sh.inpipe[0];
+			*fp++ = 0;
+			*fp++ = sh.inpipe[0];
+			*fp++ = -1;
+		}
+		if(type&FPOU)
+		{
+			*fp++ = sh.outpipe[1];
+			*fp++ = 1;
+			*fp++ = sh.outpipe[1];
+			*fp++ = -1;
+			*fp++ = sh.outpipe[0];
+			*fp++ = -1;
+		}
+		*fp = -1;
+		if(fp > fdops)
+			sh.spawnfds = fdops;
 		job_fork(-1);
 		jobfork = 1;
 		spawnpid = path_spawn(path,argv,arge,pp,(grp<<1)|1);
@@ -3507,6 +3954,7 @@ static pid_t sh_ntfork(const Shnode_t *t,char *argv[],int *jobid,int topfd)
 	else
 		exitset();
 	sh_popcontext(buffp);
+	sh.spawnfds = 0;
 	if(buffp->olist)
 		free_list(buffp->olist);
 #if _use_ntfork_tcpgrp
@@ -3535,7 +3983,7 @@ static pid_t sh_ntfork(const Shnode_t *t,char *argv[],int *jobid,int topfd)
 		siglongjmp(*sh.jmplist,jmpval);
 	if(spawnpid>0)
 	{
-		_sh_fork(spawnpid,0,jobid);
+		_sh_fork(spawnpid,type,jobid);
 		job_fork(spawnpid);
 #ifdef JOBS
 		if(grp==1)
@@ -988,5 +988,32 @@ got=$(set +x; eval ': $((1 << 2))' 2>&1) \
 got=$(set +x; eval 'got=$( ((y=1<<4)); echo $y )' 2>&1; echo $got) \
 || err_exit "bitwise left shift operator fails to parse in comsub (got $(printf %q "$got"))"
 
+# ======
+# Compiled arithmetic expressions are reused, so they must bind variables at execution time
+got=$("$SHELL" -c '
+	function f { typeset x=5; print $((x+1)); }
+	x=1
+	for i in 1 2
+	do	f; print $((x+1))
+		(( nv=i )); print $((nv+0)); unset nv
+		typeset -i n=0; n=n+i; print $n; unset n
+	done
+	function .sh.math.g a { (( .sh.value = a*2 )); }
+	print $((g(3)))
+	function .sh.math.g a { (( .sh.value = a*3 )); }
+	print $((g(3)))
+' 2>&1)
+exp=$'6\n2\n1\n1\n6\n2\n2\n2\n6\n9'
+[[ $got == "$exp" ]] || err_exit "wrong results from reused arithmetic expressions" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+
+# ======
+# Integer variables are read directly by the arithmetic evaluator; their values must stay exact
+got=$("$SHELL" -c 'typeset -li a=9223372036854775807 b=-9223372036854775808; typeset -si s=32767
+	print -- $((a)) $((a-1)) $((b)) $((b+1)) $((a&255)) $((a%10)) $((s+1)); (( a -= 7 )); print -- $a' 2>&1)
+exp=$'9223372036854775807 9223372036854775806 -9223372036854775808 -9223372036854775807 255 7 32768\n9223372036854775800'
+[[ $got == "$exp" ]] || err_exit "arithmetic on integer variables near the limits" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+
 # ======
 exit $((Errors<125?Errors:125))
@@ -838,5 +838,16 @@ case $((e=$?)),$got in
 		"(expected status 3 and $(printf %q "$exp"), got status $e and $(printf %q "$got"))" ;;
 esac
 
+# ======
+# numeric indexed arrays: subshell changes must not leak, growth and unset must keep values
+got=$("$SHELL" -c 'typeset -i -a a=(1 2 3); (a[1]=99; a[300]=7); print -r -- ${a[@]}' 2>&1)
+exp='1 2 3'
+[[ $got == "$exp" ]] || err_exit 'subshell assignment to integer array element changes parent' \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+got=$("$SHELL" -c 'typeset -F1 -a f; for ((i=0; i<1000; i++)); do f[i]=i; done; unset f[500]; f+=(.5); print -r -- ${#f[@]} ${f[999]} ${f[1000]}; s=0; for i in "${!f[@]}"; do ((s+=f[i])); done; print -r -- $s' 2>&1)
+exp=$'1000 999.0 0.5\n499000.5'
+[[ $got == "$exp" ]] || err_exit 'large float array has wrong values' \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+
 # ======
 exit $((Errors<125?Errors:125))
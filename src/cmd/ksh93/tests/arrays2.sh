@@ -269,5 +269,23 @@ ini() { unset arr; typeset -a arr=((10 20) 6 8); }
 unset arr
 unset -f ini
 
+# ======
+# Unordered (hashed) associative arrays with typeset -U
+got=$("$SHELL" -c '
+	typeset -U m=([b]=2 [a]=1 [c]=3)
+	m[d]=4
+	unset "m[b]"
+	(m[x]=9)
+	print -r -- ${#m[@]} ${m[a]}${m[c]}${m[d]}
+	for k in "${!m[@]}"; do print -r -- "$k=${m[$k]}"; done | sort | paste -sd, -
+	typeset -p m | sed "s/=.*//"
+	m=([k]=v); typeset -p m
+	typeset -A o=([z]=1); typeset -U o; o[y]=2
+	typeset -p o | sed "s/=.*//"; print -r -- ${o[y]}${o[z]}
+' 2>&1)
+exp=$'3 134\na=1,c=3,d=4\ntypeset -U m\ntypeset -U m=([k]=v)\ntypeset -U o\n21'
+[[ $got == "$exp" ]] || err_exit "typeset -U" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+
 # ======
 exit $((Errors<125?Errors:125))
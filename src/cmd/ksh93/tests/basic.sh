@@ -1000,5 +1000,64 @@ do
 	|| err_exit "last command in script exec-optimized in spite of $sig trap ($pid1 == $pid2)"
 done
 
+# ======
+# External commands in pipelines are spawned without forking the shell
+if	((${.sh.stats.spawns}+1))
+then	got=$(export bincat binecho; "$SHELL" -c 'x=pipe; "$binecho" "$x" $x | "$bincat" | "$bincat"; print ${.sh.stats.forks}' 2>&1)
+	exp=$'pipe pipe\n0'
+	[[ $got == "$exp" ]] || err_exit "external commands in pipeline not spawned" \
+		"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+fi
+got=$(export bincat binecho; "$SHELL" -c 'x=0; "$binecho" $((x+=1)) | "$bincat"; "$binecho" ${x:=9} $(print $x) | "$bincat"; print $x' 2>&1)
+exp=$'1\n0 0\n0'
+[[ $got == "$exp" ]] || err_exit "side effects of pipeline element expansions leak into parent shell" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+got=$(export bincat binecho; "$SHELL" -c 'n=0; function x.get { .sh.value=v$((++n)); }; "$binecho" $x | "$bincat"; print $n $x' 2>&1)
+exp=$'v1\n0 v1'
+[[ $got == "$exp" ]] || err_exit "get discipline of pipeline element expansion run in parent shell" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+got=$(export bincat binecho; "$SHELL" -c 'RANDOM=5; "$binecho" $RANDOM | "$bincat" >/dev/null; a=$RANDOM; RANDOM=5; print $((a == RANDOM))' 2>&1)
+[[ $got == 1 ]] || err_exit "\$RANDOM in pipeline element expanded in parent shell breaks seeded sequence (got $(printf %q "$got"))"
+got=$(export bincat binecho; "$SHELL" -c 'function cat { "$bincat" | "$bincat" -n; }; "$binecho" a | cat | cat' 2>&1)
+exp=$'     1\t     1\ta'
+[[ $got == "$exp" ]] || err_exit "function not called in pipeline" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+got=$(export bincat binfalse; "$SHELL" -c 'set -o pipefail; "$binfalse" | "$bincat"; print $?' 2>&1)
+exp=1
+[[ $got == "$exp" ]] || err_exit "wrong exit status for pipeline with spawned elements and pipefail" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+
+# ======
+# Parallel 'for -P' loop
+got=$(for -P 3 -k i in 4 1 3 2 5; do sleep 0.$i; print -r "$i"; done; print -r "status $?")
+exp=$'4\n1\n3\n2\n5\nstatus 0'
+[[ $got == "$exp" ]] || err_exit "for -P -k does not keep output in list order" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+got=$(for -P 2 i in c a b; do print -r "$i"; done | sort)
+exp=$'a\nb\nc'
+[[ $got == "$exp" ]] || err_exit "for -P loses output" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+got=$(n=1; set -- 3 2 0; for -P n+1 i; do (exit $i); done; print -r "$?")
+exp=2
+[[ $got == "$exp" ]] || err_exit "wrong exit status for for -P" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+got=$(x=0; for -P 2 i in 1 2; do x=$i; break; done; print -r "$x")
+exp=0
+[[ $got == "$exp" ]] || err_exit "for -P body changed the parent shell environment" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+SECONDS=0
+for -P 4 i in 1 2 3 4; do sleep .5; done
+(( SECONDS < 1.5 )) || err_exit "for -P does not run iterations in parallel (took $SECONDS seconds)"
+got=$(set +x; eval 'function f { for -P 2 -k i in "$@"; do :; done; }' && typeset -f f)
+exp=$'function f\n{\tfor -P 2 -k i in "$@"\n\tdo\t:\n\tdone\n}'
+[[ $got == "$exp" ]] || err_exit "for -P not deparsed correctly" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+for opt in '-k' '-P' '-x' '-P 2 -P 2'
+do	got=$(set +x; eval "for $opt i in 1; do :; done" 2>&1)
+	[[ $got == *'syntax error'* ]] || err_exit "for $opt i is not a syntax error (got $(printf %q "$got"))"
+done
+got=$(set +x; for -P 0 i in 1; do :; done 2>&1)
+[[ $got == *'0: bad number'* ]] || err_exit "for -P 0 is not an error (got $(printf %q "$got"))"
+
 # ======
 exit $((Errors<125?Errors:125))
@@ -553,6 +553,31 @@ then    for i in $(command command -x ${SHELL:-ksh} -c 'print $#;[[ $1 != argume
 	command -p command -x ${SHELL:-ksh} -c 'print $#;[[ $1 == argument0 ]]' count $(longline $n) > /dev/null  2>&1
 	[[ $? != 1 ]] && err_exit 'incorrect exit status for command -x'
 fi
+# test command -x -P option
+set -- 1 2 3 4 5 6 7
+got=$(command -x -P 3 "$SHELL" -c 'print -r -- "$#" "$@"' x "$@" z | sort)
+exp=$'2 7 z\n4 1 2 3 z\n4 4 5 6 z'
+[[ $got == "$exp" ]] || err_exit "command -x -P divides arguments incorrectly" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+command -x -P 3 "$SHELL" -c 'exit $(($1 == 4 ? 4 : $1 == 7))' x "$@" z
+got=$?
+[[ $got == 4 ]] || err_exit "wrong exit status for command -x -P (expected 4, got $got)"
+set -- 1 2
+command -x -P 2 "$SHELL" -c '(($1 == 1)) && sleep .5; exit $1' x "$@"
+got=$?
+[[ $got == 2 ]] || err_exit "exit status of last command -x -P invocation lost (expected 2, got $got)"
+set -- 2 1
+got=$(command -x -P 2 "$SHELL" -c 'exit $1' x "$@" | cat; print $?)
+[[ $got == 0 ]] || err_exit "command -x -P exit status leaks into next pipeline element (expected 0, got $got)"
+got=$(set -o pipefail; command -x -P 2 "$SHELL" -c 'exit $1' x "$@" | cat; print $?)
+[[ $got == 2 ]] || err_exit "wrong exit status for command -x -P in pipeline (expected 2, got $got)"
+set -- 1 2 3 4
+SECONDS=0
+command -x -P 4 "$SHELL" -c 'sleep 1' x "$@"
+set --
+(( SECONDS < 1.8 )) || err_exit "command -x -P does not run invocations in parallel (took $SECONDS seconds)"
+got=$(command -P 2 true 2>&1)
+[[ $got == *'-P requires -x'* ]] || err_exit "command -P without -x is not an error (got $(printf %q "$got"))"
 # test for debug trap
 [[ $(typeset -i i=0
 	trap 'print $i' DEBUG
@@ -1442,6 +1467,21 @@ got="$($SHELL -i "$hist_error_leak" 2>&1)"
 [[ $exp == "$got" ]] || err_exit "file descriptor leak after substitution error in hist builtin" \
 	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
 
+# ======
+# Searching the history must find the most recent match, including commands added after a previous search
+hist_search=$tmp/hist_search.sh
+for ((i=1; i<=2000; i++)) do
+	print "true cmd$i"
+done > "$hist_search"
+print 'hist -s "true cmd1"\ntrue cmd1x\nhist -s "true cmd1"\nhist -s "true cmd15"\nhist -s "true cmd23"\nhist -s "true cmd1x"' >> "$hist_search"
+exp=$'true cmd1999\ntrue cmd1x\ntrue cmd1599\ntrue cmd239\ntrue cmd1x'
+got=$(HISTFILE=$tmp/hist_search HISTSIZE=5000 "$SHELL" -i "$hist_search" 2>&1)
+[[ $got == "$exp" ]] || err_exit "hist -s finds wrong command" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+got=$(HISTFILE=$tmp/hist_search HISTSIZE=5000 "$SHELL" -i "$hist_search" 2>&1)
+[[ $got == "$exp" ]] || err_exit "hist -s finds wrong command with existing history file" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+
 # ======
 # printf -v works as of 2021-11-18
 ((.sh.version >= 20211118)) && {
@@ -1599,5 +1639,32 @@ do	case $bltin in
 	[[ $got == "  version  "* ]] || err_exit "$bltin does not support --version (got $(printf %q "$got"))"
 done 3< <(builtin)
 
+# ======
+# mkservice and eloop (only compiled with SHOPT_MKSERVICE)
+if	builtin mkservice eloop 2>/dev/null
+then	got=$(
+		port=$((20000 + $$ % 10000))
+		mkservice svc /dev/tcp/localhost/$port || exit
+		function svc.accept { print -r -- "accept" >>$tmp/svc.out; }
+		function svc.action
+		{
+			typeset line
+			read -r -u$1 line || return 1
+			print -r -- "got $line" >>$tmp/svc.out
+		}
+		function svc.close { print -r -- "close" >>$tmp/svc.out; }
+		for i in 1 2 3
+		do	( exec 3<>/dev/tcp/localhost/$port; print -u3 "hello $i"; print -u3 "bye $i"; sleep .2 ) &
+		done
+		eloop -t 1000
+		print "eloop returned $?"
+		unset svc
+		sort "$tmp/svc.out"
+	)
+	exp=$'eloop returned 0\naccept\naccept\naccept\nclose\nclose\nclose\ngot bye 1\ngot bye 2\ngot bye 3\ngot hello 1\ngot hello 2\ngot hello 3'
+	[[ $got == "$exp" ]] || err_exit "mkservice/eloop does not serve connections" \
+		"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+fi
+
 # ======
 exit $((Errors<125?Errors:125))
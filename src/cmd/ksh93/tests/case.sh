@@ -170,5 +170,26 @@ case \\x in \\${p}x)		warning "match: ormaaj case test 14 [unspecified]";; esac
 case \\x in \\"\\"x)		err_exit "match: ormaaj case test 15";; esac
 case \\x in \\\\x)		err_exit "match: ormaaj case test 16";; esac
 
+# ======
+# The compiled pattern cache must return the right pattern after entries are evicted and reused
+got=$(
+	n=0
+	for ((i=0; i<3; i++))
+	do	for ((j=0; j<200; j++))
+		do	[[ x$j == x$j ]] && [[ y$j == @(x|y)$j?(z) ]] && [[ y$j != x$j ]] && ((n++))
+			case $((j%7))$j in
+			?$((j+1))|?$((j-1)))
+				n=-1000 ;;
+			$((j%7))$j)
+				((n++)) ;;
+			esac
+		done
+	done
+	echo $n
+)
+exp=1200
+[[ $got == "$exp" ]] || err_exit 'pattern cache returns wrong pattern' \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+
 # ======
 exit $((Errors<125?Errors:125))
@@ -1540,5 +1540,49 @@ f || err_exit "$m"
 unset -f f
 unset -v "${!v2@}"
 
+# ======
+# Parse tree cache for dot scripts and autoloaded functions
+mkdir "$tmp/pcache" "$tmp/pcache.fun" && chmod go-w "$tmp/pcache" || err_exit "could not create cache directory"
+cat >$tmp/pcache.sh <<-'EOF'
+	function pcache_fn
+	{
+		print "fn $1 $LINENO"
+	}
+	cat <<-EOT
+		doc $(( 6 * 7 ))
+	EOT
+EOF
+print 'function pcache_af { print "af $*"; }' >$tmp/pcache.fun/pcache_af
+exp=$'doc 42\nfn x 3\naf y'
+for i in 1 2
+do	got=$(KSH_CACHEDIR=$tmp/pcache FPATH=$tmp/pcache.fun "$SHELL" -c '. "$1"; pcache_fn x; pcache_af y' _ "$tmp/pcache.sh" 2>&1)
+	[[ $got == "$exp" ]] || err_exit "parse cache: wrong output on run $i" \
+		"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+done
+set -- "$tmp"/pcache/*
+(($# == 2)) || err_exit "parse cache: expected 2 cache files, got $#"
+print 'print changed' >>$tmp/pcache.sh
+got=$(KSH_CACHEDIR=$tmp/pcache "$SHELL" -c '. "$1"' _ "$tmp/pcache.sh" 2>&1)
+exp=$'doc 42\nchanged'
+[[ $got == "$exp" ]] || err_exit "parse cache: stale cache file used after script was modified" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+print 'pcache_al' >$tmp/pcache2.sh
+rm -f "$tmp"/pcache/*
+got=$(KSH_CACHEDIR=$tmp/pcache "$SHELL" -c 'alias pcache_al="print aliased"; . "$1"' _ "$tmp/pcache2.sh" 2>&1)
+[[ $got == aliased ]] || err_exit "parse cache: alias not expanded (got $(printf %q "$got"))"
+set -- "$tmp"/pcache/*
+[[ -e $1 ]] && err_exit "parse cache: parse depending on aliases was cached"
+set --
+print 'Pt_t p=(x=5); print "${p.x}"' >$tmp/pcache3.sh
+got=$(KSH_CACHEDIR=$tmp/pcache "$SHELL" -c 'typeset -T Pt_t=(integer x); . "$1"' _ "$tmp/pcache3.sh" 2>&1)
+[[ $got == 5 ]] || err_exit "parse cache: type not used (got $(printf %q "$got"))"
+got=$(KSH_CACHEDIR=$tmp/pcache "$SHELL" -c '. "$1"' _ "$tmp/pcache3.sh" 2>&1; print "status $?")
+exp=$'syntax error at line 1: `(\' unexpected\nstatus 3'
+[[ $got == *"$exp" ]] || err_exit "parse cache: parse depending on a type was reused" \
+	"(expected match of *$(printf %q "$exp"), got $(printf %q "$got"))"
+set -- "$tmp"/pcache/*
+[[ -e $1 ]] && err_exit "parse cache: parse depending on a type was cached"
+set --
+
 # ======
 exit $((Errors<125?Errors:125))
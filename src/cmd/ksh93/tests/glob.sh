@@ -408,6 +408,17 @@ test_glob '<d_un/d_sym//d_3> <d_un/d_sym//d_3/d_4> <d_un/d_sym//d_tres> <d_un/d_
 test_glob '<d_un/d_sym//d_3> <d_un/d_sym//d_3/d_4> <d_un/d_sym//d_tres> <d_un/d_sym//d_tres/d_quatro>' **/d_[s]ym//**
 test_glob '<d_un/d_sym//d_3> <d_un/d_sym//d_3/d_4> <d_un/d_sym//d_tres> <d_un/d_sym//d_tres/d_quatro>' **/d_*ym//**
 
+# File types reported by readdir(3) are used instead of stat(2) where possible; check that
+# directories, files and symlinks to directories are still told apart correctly
+touch d_un/d_duo/d_3/f_1 d_un/d_duo/d_3/d_4/f_2
+set --markdirs
+test_glob '<d_un/d_duo/d_3/> <d_un/d_duo/d_3/d_4/> <d_un/d_duo/d_3/d_4/f_2> <d_un/d_duo/d_3/f_1>'\
+' <d_un/d_duo/d_tres/> <d_un/d_duo/d_tres/d_quatro/>' d_un/d_duo/**
+test_glob '<d_un/d_duo/d_3/d_4/f_2> <d_un/d_duo/d_3/f_1>' d_un/**/f_*
+test_glob '<d_un/d_duo/d_3/> <d_un/d_duo/d_3/d_4/> <d_un/d_duo/d_tres/> <d_un/d_duo/d_tres/d_quatro/>' d_un/d_duo/**/
+set --nomarkdirs
+rm d_un/d_duo/d_3/f_1 d_un/d_duo/d_3/d_4/f_2
+
 set --noglobstar
 
 # ======
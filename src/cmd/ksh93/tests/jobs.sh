@@ -86,5 +86,46 @@ j2=${ jobs; }
 kill %- %+
 [[ $j2 == "$j1" ]] || err_exit "jobs lost after shared-state command substitution ($(printf %q "$j2") != $(printf %q "$j1"))"
 
+# ======
+# The exit statuses of many background jobs, running or done, must be kept apart
+typeset -a pids
+for ((i=0; i<300; i++))
+do	if	((i%2))
+	then	(exit $((i%256))) &
+	else	(sleep .5; exit $((i%256))) &
+	fi
+	pids[i]=$!
+done
+sleep .2
+got=
+for ((i=299; i>=0; i--))
+do	wait "${pids[i]}"
+	(($? == i%256)) || got+=" $i:$?"
+done
+[[ -z $got ]] || err_exit "wrong exit status for background jobs (got$got)"
+unset pids
+
+# ======
+# wait -t
+sleep 2 &
+SECONDS=0
+wait -t .2 $!
+got=$?
+(( SECONDS < 1.5 )) || err_exit "wait -t does not time out (took $SECONDS seconds)"
+exp=$((128 + $(kill -l ALRM)))
+[[ $got == "$exp" ]] || err_exit "wrong exit status for wait -t timeout (expected $exp, got $got)"
+wait -t 0.1 && err_exit "wait -t without job operands does not time out"
+kill $!
+(sleep .1; exit 3) &
+wait -t 5 $!
+got=$?
+[[ $got == 3 ]] || err_exit "wrong exit status for wait -t on a job that terminates (expected 3, got $got)"
+for t in abc -1 1x ''
+do	got=$(set +x; { wait -t "$t"; } 2>&1; print "status $?")
+	exp="wait: $t: bad number"$'\nstatus 2'
+	[[ $got == *"$exp" ]] || err_exit "wait -t accepts an invalid timeout '$t'" \
+		"(expected match of *$(printf %q "$exp"), got $(printf %q "$got"))"
+done
+
 # ======
 exit $((Errors<125?Errors:125))
@@ -74,6 +74,12 @@ if builtin cp 2> /dev/null; then
 	cp -HR "$tmp/testdir_symlink" "$tmp/result"
 	{ test -d "$tmp/result" && ! test -L "$tmp/result"; } || err_exit "'cp -HR' didn't follow the given symlink"
 	{ test -f "$tmp/result/testfile2_sym" && test -L "$tmp/result/testfile2_sym"; } || err_exit "'cp -HR' follows symlinks not given on the command line"
+	# Copy a file larger than any I/O buffer
+	for ((i=0; i<5000; i++))
+	do	print "line $i of the file to copy"
+	done > "$tmp/cp_large"
+	cp "$tmp/cp_large" "$tmp/cp_large2"
+	cmp -s "$tmp/cp_large" "$tmp/cp_large2" || err_exit "'cp' of a large file does not copy it intact"
 fi
 
 # ======
@@ -207,6 +213,30 @@ if builtin wc 2> /dev/null; then
 	got=$(wc -N "$tmp/file2")
 	exp="       7      38     158 $tmp/file2"
 	[[ $got == "$exp" ]] || err_exit "'wc -N' failed (expected $(printf %q "$exp"), got $(printf %q "$got"))"
+
+	# The word and line counts must not depend on where words fall in a buffer
+	lines=0 words=0 exp=
+	for ((i = 1; i <= 300; i++))
+	do	for ((j = 0; j < i % 19; j++))
+		do	exp+=w
+		done
+		((j)) && ((words++))
+		case $((i % 7)) in
+		0)	exp+=$'\n'; ((lines++)) ;;
+		1)	exp+=$'\t' ;;
+		2)	exp+=$'\r\v\f' ;;
+		*)	exp+=' ' ;;
+		esac
+	done
+	print -rn -- "$exp" > "$tmp/file3"
+	exp="$(printf '%8d%8d%8d' lines words ${#exp}) $tmp/file3"
+	got=$(wc "$tmp/file3")
+	[[ $got == "$exp" ]] || err_exit "'wc' miscounts words at buffer offsets" \
+		"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+	exp=$(printf '%8d%8d%8d' 1 3 8)
+	got=$( { print -n 'ab'; sleep .01; print -n ' c'; sleep .01; print 'd e'; } | wc)
+	[[ $got == "$exp" ]] || err_exit "'wc' miscounts words split across reads" \
+		"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
 fi
 
 # ======
@@ -559,6 +589,16 @@ if builtin cat 2> /dev/null; then
 	exp="a^Ib"
 	[[ $got == "$exp" ]] || err_exit "cat -T failed to convert tabs to ^I. (expected $(printf %q "$exp"), got $(printf %q "$got"))"
 
+	# Files copied without processing must stay in order with buffered output
+	print one > "$tmp/file1"
+	print two > "$tmp/file2"
+	{ print start; cat "$tmp/file1"; print mid; cat "$tmp/file2" "$tmp/file1"; print end; } > "$tmp/catout"
+	print more >> "$tmp/catout"
+	cat "$tmp/file2" >> "$tmp/catout"
+	got=$(< "$tmp/catout"),$(cat "$tmp/file1" "$tmp/file2"),$(print x | cat "$tmp/file1" - "$tmp/file2")
+	exp=$'start\none\nmid\ntwo\none\nend\nmore\ntwo,one\ntwo,one\nx\ntwo'
+	[[ $got == "$exp" ]] || err_exit "cat output out of order (expected $(printf %q "$exp"), got $(printf %q "$got"))"
+
 	got=$(cat this_file_does_not_exist 2>&1)
 	exp="this_file_does_not_exist: cannot open"
 	[[ $got =~ $exp ]] || err_exit "cat should give an error on non-existent files (expected $(printf %q "$exp"), got $(printf %q "$got"))"
@@ -906,4 +946,37 @@ if builtin getconf 2> /dev/null; then
 		"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
 fi
 # ======
+# Tests for the cksum and md5sum builtins
+if builtin md5sum 2> /dev/null; then
+	mkdir -p "$tmp/sums/a" "$tmp/sums/b"
+	for ((i = 0; i < 40; i++))
+	do	print -r -- "$i ${ printf '%0*d' $((i * 97)) 0; }" > "$tmp/sums/$( ((i & 1)) && echo a || echo b)/$i"
+	done
+	exp=$(md5sum -R "$tmp/sums")
+	got=$(md5sum --jobs=3 -R "$tmp/sums")
+	[[ $got == "$exp" ]] || err_exit "'md5sum --jobs' output differs from one job" \
+		"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+	print -r -- "$exp" > "$tmp/sums.md5"
+	print x >> "$tmp/sums/a/1"
+	exp=$(md5sum -c "$tmp/sums.md5" 2>&1)
+	got=$(md5sum --jobs=3 -c "$tmp/sums.md5" 2>&1)
+	[[ $got == "$exp" ]] || err_exit "'md5sum --jobs --check' output differs from one job" \
+		"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+	md5sum --jobs=3 -c "$tmp/sums.md5" 2> /dev/null && err_exit "'md5sum --jobs --check' exit status is 0 for a changed file"
+	# the accelerated block functions must match the known answers at every block boundary
+	s=
+	for ((i = 0; i < 600; i++))
+	do	s+=$((i * 7919 % 10007)),
+	done
+	for m in sha1:f744991c2f2eb1cfb3effc2809bc2c4d sha256:87b987b97909f39ccf1b181e8b734c57 \
+		posix:6a9558a804c358b55e814a6ba5211c25 zip:9c31f8b8f3e0e122e844c57010d4f60c
+	do	exp=${m#*:}
+		got=$(for n in 0 1 55 56 63 64 65 119 120 127 128 129 191 192 255 256 1000 ${#s}
+		do	print -rn -- "${s:0:n}" | md5sum -x "${m%%:*}"
+		done | md5sum)
+		[[ $got == "$exp" ]] || err_exit "'md5sum -x ${m%%:*}' gives wrong checksums" \
+			"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+	done
+fi
+# ======
 exit $((Errors<125?Errors:125))
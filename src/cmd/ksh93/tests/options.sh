@@ -629,5 +629,43 @@ do
 		"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
 done
 
+# ======
+# set -o profile
+if	[[ -o ?profile ]]
+then	got=$(KSH_PROFILE=$tmp/prof "$SHELL" -c '
+		set -o profile
+		function g { ((n++)); }
+		function f { g; g; }
+		f; f; /bin/true
+		' 2>&1)
+	[[ $got == '' ]] || err_exit "set -o profile writes to stderr when KSH_PROFILE is set (got $(printf %q "$got"))"
+	got=$(<$tmp/prof)
+	[[ $got == *' g:3'$'\n'* && $got == *' total'$'\n'* ]] || err_exit 'set -o profile: flat profile is wrong' \
+		"(got $(printf %q "$got"))"
+	[[ $got == *$'\n'*' 4 '*' g'$'\n'*' 4 '*'called from f:4' ]] || err_exit 'set -o profile: call graph is wrong' \
+		"(got $(printf %q "$got"))"
+	exp=$'main;f:4\nmain;f;g:3'
+	got=$(sed 's/ [0-9]*$//' "$tmp/prof.folded" | grep 'main;f' | LC_ALL=C sort)
+	[[ $got == "$exp" ]] || err_exit 'set -o profile: folded stacks are wrong' \
+		"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+	# functions left by 'exit' must not be charged for the commands that follow
+	KSH_PROFILE=$tmp/prof "$SHELL" -c '
+		set -o profile
+		function f { exit 3; }
+		g() { exit 3; }
+		s=$(printf "%0200000d" 0)
+		: "$(f)" "$(g)" "${s//0/ab}"
+		'
+	typeset -A t
+	while read -r stack usec
+	do	t[$stack]=$usec
+	done < "$tmp/prof.folded"
+	for stack in 'main;f:3' 'main;g:4'
+	do	(( t[$stack] * 10 < t[main:6] )) || err_exit "set -o profile: $stack charged after unwinding" \
+			"(got $(printf %q "$(<$tmp/prof.folded)"))"
+	done
+	unset t
+fi
+
 # ======
 exit $((Errors<125?Errors:125))
@@ -982,5 +982,18 @@ then	got=$(PATH=/opt/ast/bin:$PATH "$SHELL" -c 'command -x cat /dev/null; whence
 	        "(expected $(printf %q "$exp"), got $(printf %q "$got"))"
 fi
 
+# ======
+# A command added to or removed from a PATH directory after a failed search must be noticed
+mkdir "$tmp/pathsnap" && touch -t 202001010000 "$tmp/pathsnap"
+got=$(PATH=$tmp/pathsnap:$PATH "$SHELL" -c '
+	command -v snapcmd || print miss
+	print "print found" >"$1/snapcmd" && chmod +x "$1/snapcmd"
+	snapcmd
+	rm "$1/snapcmd" && hash -r
+	command -v snapcmd || print miss' _ "$tmp/pathsnap" 2>&1)
+exp=$'miss\nfound\nmiss'
+[[ $got == "$exp" ]] || err_exit "PATH search misses changes to directory" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+
 # ======
 exit $((Errors<125?Errors:125))
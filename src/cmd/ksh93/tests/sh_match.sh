@@ -1064,5 +1064,21 @@ EOF
 		$'Diff follows:\n'"$(diff -u <(print -r -- "$exp") <(print -r -- "$got") | sed $'s/^/\t| /')"
 fi
 
+# ======
+# Patterns containing a literal string are prefiltered by scanning for that string
+[[ aaaac =~ aaab*c ]] || err_exit "overlapping literal candidate skipped"
+[[ xxERRORyy == *ERROR* ]] || err_exit "*ERROR* does not match"
+[[ xxERRORyy == *ERROR ]] && err_exit "*ERROR matches with trailing text"
+[[ ERRORyy == ERROR* ]] || err_exit "ERROR* does not match"
+[[ xERRORyy == ERROR* ]] && err_exit "ERROR* matches with leading text"
+[[ xxERRORyy == ??ERROR* ]] || err_exit "??ERROR* does not match"
+[[ xxxERRORyy == ??ERROR* ]] && err_exit "??ERROR* matches with extra leading text"
+[[ $'line 1\nline 2 ERROR' == *$'\n'*ERROR ]] || err_exit "literal after newline does not match"
+x=abcabcabdabcabd
+got=${x/abcabd/X},${x//abcabd/X},${x#*abcabd},${x##*abc},${x%abcabd*}
+exp=abcXabcabd,abcXX,abcabd,abd,abcabcabd
+[[ $got == "$exp" ]] || err_exit "literal substring expansions" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+
 # ======
 exit $((Errors<125?Errors:125))
@@ -1181,5 +1181,27 @@ exp='some output'
 [[ $got == "$exp" ]] || err_exit 'command substitution did not catch output' \
 	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
 
+# ======
+# Pipelines of built-ins in command substitutions don't fork
+if	((${.sh.stats.forks}+1))
+then	got=$("$SHELL" -c '
+		x=$(print a:b:c | IFS=: read p q r; print -r -- "$q")
+		y=$(printf "%s\n" 3 2 1 | read; print "$REPLY" | read z; print "$z")
+		print -r -- "$x $y ${.sh.stats.forks}"' 2>&1)
+	exp='b 3 0'
+	[[ $got == "$exp" ]] || err_exit "builtin-only pipeline in command substitution" \
+		"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+fi
+got=$(print a | read v; print "[$v]"; let w=5 | read x; print "[$w]")
+exp=$'[a]\n[]'
+[[ $got == "$exp" ]] || err_exit "non-forking pipeline not run in a subshell" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+got=$(set -o pipefail; print x | false | true; print $?; print x | true | false; print $?)
+exp=$'1\n1'
+[[ $got == "$exp" ]] || err_exit "wrong exit status for non-forking pipeline with pipefail" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+got=$(function print { command print -r -- "f$@"; }; print a | read v; command print -r -- "$v")
+[[ $got == fa ]] || err_exit "function overriding built-in not used in pipeline (got $(printf %q "$got"))"
+
 # ======
 exit $((Errors<125?Errors:125))
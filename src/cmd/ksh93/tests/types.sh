@@ -793,5 +793,20 @@ got=$({ "$SHELL" -c '
 '; } 2>&1) || err_exit 'crash involving short int as first type member' \
 	"(got status $e$( ((e>128)) && print -n /SIG && kill -l "$e"), $(printf %q "$got"))"
 
+# ======
+# Members of a compound variable moved away with typeset -m must not be found under the old name
+got=$("$SHELL" -c '
+	typeset -T Foo_t=( typeset y=(xa=xx) )
+	Foo_t t=(y=(xa=bb))
+	typeset -m r=t
+	[[ ${r.y.xa} == bb ]]
+	typeset -m t=r
+	Foo_t r
+	print -r "${r.y.xa} ${t.y.xa}"
+' 2>&1)
+exp='xx bb'
+[[ $got == "$exp" ]] || err_exit "stale compound variable member after typeset -m" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+
 # ======
 exit $((Errors<125?Errors:125))
@@ -1563,5 +1563,56 @@ exp=3,[a/-/b]
 	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
 IFS=$' \t\n'  # restore default
 
+# ======
+# Variable lookups must stay correct with more variables than fit in the name cache
+got=$("$SHELL" -c '
+	for v in a b c d e f g h i j k l m n o p q r s t u v w x y z
+	do	eval "$v=g$v"
+	done
+	function f
+	{
+		typeset a=la m=lm z=lz
+		print -r "$a$b$m$n$y$z"
+		unset b; b=nb
+		print -r "$a$b$m$n$y$z"
+	}
+	for i in 1 2
+	do	print -r "$a$b$m$n$y$z"
+		f
+	done
+	print -r "$a$b$m$n$y$z"
+' 2>&1)
+exp=$'gagbgmgngygz\nlagblmgngylz\nlanblmgngylz\nganbgmgngygz\nlanblmgngylz\nlanblmgngylz\nganbgmgngygz'
+[[ $got == "$exp" ]] || err_exit "wrong variable values with many variables and local scopes" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+
+# ======
+# The environment list passed to external commands must follow every change to exported variables
+got=$("$SHELL" -c '
+	env=$(whence -p env)
+	export foo=1 bar=1
+	"$env" | grep ^foo=
+	foo=2
+	"$env" | grep ^foo=
+	function f
+	{
+		typeset foo=local
+		"$env" | grep -c ^foo=
+		typeset -x foo=exported
+		"$env" | grep ^foo=
+	}
+	f
+	"$env" | grep ^foo=
+	(foo=sub; "$env" | grep ^foo=)
+	"$env" | grep ^foo=
+	typeset +x foo
+	"$env" | grep -c ^foo=
+	typeset -i -x bar; (( bar++ ))
+	"$env" | grep ^bar=
+' 2>&1)
+exp=$'foo=1\nfoo=2\n0\nfoo=exported\nfoo=2\nfoo=sub\nfoo=2\n0\nbar=2'
+[[ $got == "$exp" ]] || err_exit "environment of external commands not updated" \
+	"(expected $(printf %q "$exp"), got $(printf %q "$got"))"
+
 # ======
 exit $((Errors<125?Errors:125))
@@ -25,6 +25,14 @@
  *		 0	nothing		[retain session and process group]
  *		 1	setpgid(0,0)	[process group leader]
  *		>1	setpgid(0,pgid)	[join process group]
+ *
+ * spawnvefd -- spawnveg with file descriptor operations
+ *
+ *	fdops is 0 or a list of file descriptor pairs terminated by -1,
+ *	applied in order in the new process before the exec:
+ *
+ *	fd,newfd	dup2(fd,newfd)
+ *	fd,-1		close(fd)
  */
 
 #include <ast.h>
@@ -35,15 +43,26 @@
 #include <error.h>
 #include <wait.h>
 
+static int
+addfdops(posix_spawn_file_actions_t* ap, const int* fdops)
+{
+	int	err;
+
+	for (; fdops[0] >= 0; fdops += 2)
+		if (err = fdops[1] >= 0 ? posix_spawn_file_actions_adddup2(ap, fdops[0], fdops[1]) : posix_spawn_file_actions_addclose(ap, fdops[0]))
+			return err;
+	return 0;
+}
+
 pid_t
-spawnveg(const char* path, char* const argv[], char* const envv[], pid_t pgid, int tcfd)
+spawnvefd(const char* path, char* const argv[], char* const envv[], pid_t pgid, int tcfd, const int* fdops)
 {
 	int				err, flags = 0;
 	pid_t				pid;
 	posix_spawnattr_t		attr;
-#if _lib_posix_spawn_file_actions_addtcsetpgrp_np
 	posix_spawn_file_actions_t	actions;
-#else
+	posix_spawn_file_actions_t*	ap = NiL;
+#if !_lib_posix_spawn_file_actions_addtcsetpgrp_np
 	NOT_USED(tcfd);
 #endif
 
@@ -65,32 +84,49 @@ spawnveg(const char* path, char* const argv[], char* const envv[], pid_t pgid, i
 			goto bad;
 	}
 #if _lib_posix_spawn_file_actions_addtcsetpgrp_np
-	if (tcfd >= 0)
+	if (tcfd >= 0 || fdops)
+#else
+	if (fdops)
+#endif
 	{
 		if (err = posix_spawn_file_actions_init(&actions))
 			goto bad;
-		if (err = posix_spawn_file_actions_addtcsetpgrp_np(&actions, tcfd))
-			goto fail;
+		ap = &actions;
 	}
-	if (err = posix_spawn(&pid, path, (tcfd >= 0) ? &actions : NiL, &attr, argv, envv ? envv : environ))
-#else
-	if (err = posix_spawn(&pid, path, NiL, &attr, argv, envv ? envv : environ))
+#if _lib_posix_spawn_file_actions_addtcsetpgrp_np
+	if (tcfd >= 0 && (err = posix_spawn_file_actions_addtcsetpgrp_np(ap, tcfd)))
+		goto fail;
 #endif
+	if (fdops && (err = addfdops(ap, fdops)))
+		goto fail;
+	if (err = posix_spawn(&pid, path, ap, &attr, argv, envv ? envv : environ))
 	{
-		if ((err != EPERM) || (err = posix_spawn(&pid, path, NiL, NiL, argv, envv ? envv : environ)))
+		if (err != EPERM)
+			goto fail;
+		/* retry without process group and terminal control */
+		if (ap)
+		{
+			posix_spawn_file_actions_destroy(ap);
+			ap = NiL;
+		}
+		if (fdops)
+		{
+			if (err = posix_spawn_file_actions_init(&actions))
+				goto bad;
+			ap = &actions;
+			if (err = addfdops(ap, fdops))
+				goto fail;
+		}
+		if (err = posix_spawn(&pid, path, ap, NiL, argv, envv ? envv : environ))
 			goto fail;
 	}
-#if _lib_posix_spawn_file_actions_addtcsetpgrp_np
-	if (tcfd >= 0)
-		posix_spawn_file_actions_destroy(&actions);
-#endif
+	if (ap)
+		posix_spawn_file_actions_destroy(ap);
 	posix_spawnattr_destroy(&attr);
 	return pid;
  fail:
-#if _lib_posix_spawn_file_actions_addtcsetpgrp_np
-	if (tcfd >= 0)
-		posix_spawn_file_actions_destroy(&actions);
-#endif
+	if (ap)
+		posix_spawn_file_actions_destroy(ap);
  bad:
 	posix_spawnattr_destroy(&attr);
  nope:
@@ -112,9 +148,14 @@ spawnveg(const char* path, char* const argv[], char* const envv[], pid_t pgid, i
 #endif
 
 pid_t
-spawnveg(const char* path, char* const argv[], char* const envv[], pid_t pgid, int tcfd)
+spawnvefd(const char* path, char* const argv[], char* const envv[], pid_t pgid, int tcfd, const int* fdops)
 {
 	NOT_USED(tcfd);
+	if (fdops)
+	{
+		errno = ENOSYS;
+		return -1;
+	}
 #if defined(P_DETACH)
 	return spawnve(pgid ? P_DETACH : P_NOWAIT, path, argv, envv ? envv : environ);
 #else
@@ -133,11 +174,16 @@ spawnveg(const char* path, char* const argv[], char* const envv[], pid_t pgid, i
  */
 
 pid_t
-spawnveg(const char* path, char* const argv[], char* const envv[], pid_t pgid, int tcfd)
+spawnvefd(const char* path, char* const argv[], char* const envv[], pid_t pgid, int tcfd, const int* fdops)
 {
 	struct inheritance	inherit;
 
 	NOT_USED(tcfd);
+	if (fdops)
+	{
+		errno = ENOSYS;
+		return -1;
+	}
 	inherit.flags = 0;
 	if (pgid)
 	{
@@ -171,7 +217,7 @@ spawnveg(const char* path, char* const argv[], char* const envv[], pid_t pgid, i
  */
 
 pid_t
-spawnveg(const char* path, char* const argv[], char* const envv[], pid_t pgid, int tcfd)
+spawnvefd(const char* path, char* const argv[], char* const envv[], pid_t pgid, int tcfd, const int* fdops)
 {
 	int			n;
 	int			m;
@@ -188,7 +234,7 @@ spawnveg(const char* path, char* const argv[], char* const envv[], pid_t pgid, i
 	if (!envv)
 		envv = environ;
 #if _lib_spawnve
-	if (!pgid)
+	if (!pgid && !fdops)
 		return spawnve(path, argv, envv);
 #endif /* _lib_spawnve */
 	n = errno;
@@ -232,6 +278,12 @@ spawnveg(const char* path, char* const argv[], char* const envv[], pid_t pgid, i
 				ioctl(2, TIOCSPGRP, &pgid);
 #endif /* _lib_tcgetpgrp */
 		}
+		if (fdops)
+			for (; fdops[0] >= 0; fdops += 2)
+				if (fdops[1] >= 0)
+					dup2(fdops[0], fdops[1]);
+				else
+					close(fdops[0]);
 		execve(path, argv, envv);
 #if _real_vfork
 		*exec_errno_ptr = errno;
@@ -296,3 +348,9 @@ spawnveg(const char* path, char* const argv[], char* const envv[], pid_t pgid, i
 #endif
 
 #endif
+
+pid_t
+spawnveg(const char* path, char* const argv[], char* const envv[], pid_t pgid, int tcfd)
+{
+	return spawnvefd(path, argv, envv, pgid, tcfd, NiL);
+}
@@ -44,6 +44,7 @@
 #define MATCH_RAW	1
 #define MATCH_MAKE	2
 #define MATCH_META	4
+#define MATCH_DIR	8	/* rescan entry is known to be a directory */
 
 #define MATCHPATH(g)	(offsetof(globlist_t,gl_path)+(g)->gl_extra)
 
@@ -95,7 +96,9 @@ gl_dirnext(glob_t* gp, void* handle)
 	while (dp = (struct dirent*)(*gp->gl_readdir)(handle))
 	{
 #ifdef D_TYPE
-		if (D_TYPE(dp) != DT_UNKNOWN && D_TYPE(dp) != DT_DIR && D_TYPE(dp) != DT_LNK)
+		if (D_TYPE(dp) == DT_DIR)
+			gp->gl_status |= GLOB_ISDIR;
+		else if (D_TYPE(dp) != DT_UNKNOWN && D_TYPE(dp) != DT_LNK)
 			gp->gl_status |= GLOB_NOTDIR;
 #endif
 		return dp->d_name;
@@ -230,12 +233,16 @@ trim(register char* sp, register char* p1, int* n1, register char* p2, int* n2)
 	} while (*dp++ = c);
 }
 
+/*
+ * <type> is GLOB_DIR or GLOB_REG if gl_dirnext() has told whether or not the
+ * entry is a directory, in which case no gl_type() call is needed to find out
+ */
+
 static void
-addmatch(register glob_t* gp, const char* dir, const char* pat, register const char* rescan, char* endslash, int meta)
+addmatch(register glob_t* gp, const char* dir, const char* pat, register const char* rescan, char* endslash, int meta, int type)
 {
 	register globlist_t*	ap;
 	int			offset;
-	int			type;
 
 	stakseek(MATCHPATH(gp));
 	if (dir)
@@ -248,7 +255,7 @@ addmatch(register glob_t* gp, const char* dir, const char* pat, register const c
 	stakputs(pat);
 	if (rescan)
 	{
-		if ((*gp->gl_type)(gp, stakptr(MATCHPATH(gp)), 0) != GLOB_DIR)
+		if (type != GLOB_DIR && (type || (*gp->gl_type)(gp, stakptr(MATCHPATH(gp)), 0) != GLOB_DIR))
 			return;
 		stakputc(gp->gl_delim);
 		offset = staktell();
@@ -263,10 +270,14 @@ addmatch(register glob_t* gp, const char* dir, const char* pat, register const c
 		ap->gl_begin = (char*)rescan;
 		ap->gl_next = gp->gl_rescan;
 		gp->gl_rescan = ap;
+		if (type == GLOB_DIR)
+			meta |= MATCH_DIR;
 	}
 	else
 	{
-		if (!endslash && (gp->gl_flags & GLOB_MARK) && (type = (*gp->gl_type)(gp, stakptr(MATCHPATH(gp)), 0)))
+		if (type == GLOB_REG && (gp->gl_flags & GLOB_COMPLETE))
+			type = 0;
+		if (!endslash && (gp->gl_flags & GLOB_MARK) && (type || (type = (*gp->gl_type)(gp, stakptr(MATCHPATH(gp)), 0))))
 		{
 			if ((gp->gl_flags & GLOB_COMPLETE) && type != GLOB_EXE)
 			{
@@ -308,6 +319,8 @@ glob_dir(glob_t* gp, globlist_t* ap, int re_flags)
 	regex_t			rec;
 	regex_t			rei;
 	int			notdir;
+	int			isdir = 0;
+	int			dtype;
 	int			t1;
 	int			t2;
 	int			bracket;
@@ -353,13 +366,13 @@ again:
 			if (!first && !*rescan && *(rescan - 2) == gp->gl_delim)
 			{
 				*(rescan - 2) = 0;
-				c = (*gp->gl_type)(gp, prefix, 0);
+				c = (ap->gl_flags & MATCH_DIR) && !quote ? GLOB_DIR : (*gp->gl_type)(gp, prefix, 0);
 				*(rescan - 2) = gp->gl_delim;
 				if (c == GLOB_DIR)
-					addmatch(gp, NiL, prefix, NiL, rescan - 1, anymeta);
+					addmatch(gp, NiL, prefix, NiL, rescan - 1, anymeta, 0);
 			}
 			else if ((anymeta || !(gp->gl_flags & GLOB_NOCHECK)) && (*gp->gl_type)(gp, prefix, 0))
-				addmatch(gp, NiL, prefix, NiL, NiL, anymeta);
+				addmatch(gp, NiL, prefix, NiL, NiL, anymeta, 0);
 			return;
 		case '[':
 			if (!bracket)
@@ -430,6 +443,9 @@ again:
 				rescan -= t2;
 		}
 		*(restore1 = pat - 1) = 0;
+		/* a directory found by gl_dirnext() need not be checked again */
+		if (pat == ap->gl_begin && !savequote && (ap->gl_flags & MATCH_DIR))
+			isdir = 1;
 	}
 	if (!complete && (gp->gl_flags & GLOB_STARSTAR))
 		while (pat[0] == '*' && pat[1] == '*' && (pat[2] == '/'  || pat[2]==0))
@@ -486,7 +502,7 @@ skip:
 				break;
 			prefix = streq(dirname, ".") ? (char*)0 : dirname;
 		}
-		if ((!starstar && !gp->gl_starstar || (t1 = (*gp->gl_type)(gp, dirname, GLOB_STARSTAR)) == GLOB_DIR
+		if ((!starstar && !gp->gl_starstar || isdir || (t1 = (*gp->gl_type)(gp, dirname, GLOB_STARSTAR)) == GLOB_DIR
 			|| t1 == GLOB_SYM && pat[0]=='*' && pat[1]=='\0') /* follow symlinks to dirs for non-globstar components */
 		&& (dirf = (*gp->gl_diropen)(gp, dirname)))
 		{
@@ -539,6 +555,9 @@ skip:
 				*restore2 = gp->gl_delim;
 			while ((name = (*gp->gl_dirnext)(gp, dirf)) && !*gp->gl_intr)
 			{
+				notdir = (gp->gl_status & GLOB_NOTDIR);
+				dtype = (gp->gl_status & GLOB_ISDIR) ? GLOB_DIR : notdir ? GLOB_REG : 0;
+				gp->gl_status &= ~(GLOB_NOTDIR|GLOB_ISDIR);
 				/*
 				 * For security and usability, only match '..' or '.' as the final element if:
 				 *	- it's specified literally, or
@@ -551,18 +570,16 @@ skip:
 				&& name[0] == '.' && (!name[1] || name[1] == '.' && !name[2])
 				&& !(gp->gl_flags & GLOB_FCOMPLETE))
 					continue;
-				if (notdir = (gp->gl_status & GLOB_NOTDIR))
-					gp->gl_status &= ~GLOB_NOTDIR;
 				if (ire && !regexec(ire, name, 0, NiL, 0))
 					continue;
 				if (matchdir && (name[0] != '.' || name[1] && (name[1] != '.' || name[2])) && !notdir)
-					addmatch(gp, prefix, name, matchdir, NiL, anymeta);
+					addmatch(gp, prefix, name, matchdir, NiL, anymeta, dtype);
 				if (!regexec(pre, name, 0, NiL, 0))
 				{
 					if (!rescan || !notdir)
-						addmatch(gp, prefix, name, rescan, NiL, anymeta);
+						addmatch(gp, prefix, name, rescan, NiL, anymeta, dtype);
 					if (starstar==1 || (starstar==2 && !notdir))
-						addmatch(gp, prefix, name, starstar==2?"":NiL, NiL, anymeta);
+						addmatch(gp, prefix, name, starstar==2?"":NiL, NiL, anymeta, dtype);
 				}
 				errno = 0;
 			}
@@ -20,7 +20,7 @@
  * Glenn Fowler
  * AT&T Bell Laboratories
  *
- * copy from rfd to wfd (with conditional mmap hacks)
+ * copy from rfd to wfd (with conditional kernel copy and mmap hacks)
  */
 
 #include <ast.h>
@@ -34,9 +34,41 @@
 
 #endif
 
+#if _lib_copy_file_range || _lib_sendfile_linux || _lib_splice
+
+#include <errno.h>
+#include <fcntl.h>
+#if _lib_sendfile_linux
+#include <sys/sendfile.h>
+#endif
+
+#define KERNSIZE	(1024*1024*16)
+
+/*
+ * kernel copy methods found not to apply to the current rfd/wfd pair
+ */
+
+#define KERN_RANGE	01
+#define KERN_SENDFILE	02
+#define KERN_SPLICE	04
+
+/*
+ * errno values for a kernel copy method that does not apply to rfd/wfd
+ */
+
+#ifdef EOPNOTSUPP
+#define unsupported(e)	((e)==EINVAL||(e)==ENOSYS||(e)==EXDEV||(e)==EBADF||(e)==ESPIPE||(e)==EOPNOTSUPP)
+#else
+#define unsupported(e)	((e)==EINVAL||(e)==ENOSYS||(e)==EXDEV||(e)==EBADF||(e)==ESPIPE)
+#endif
+
+#endif
+
 #undef	BUFSIZ
 #define BUFSIZ		4096
 
+#define COPYSIZE	(BUFSIZ*16)
+
 /*
  * copy n bytes from rfd to wfd
  * actual byte count returned
@@ -47,8 +79,10 @@ off_t
 astcopy(int rfd, int wfd, off_t n)
 {
 	register off_t	c;
-#ifdef MAPSIZE
+#if defined(MAPSIZE) || defined(KERNSIZE)
 	off_t		pos;
+#endif
+#ifdef MAPSIZE
 	off_t		mapsize;
 	char*		mapbuf;
 	struct stat	st;
@@ -56,31 +90,119 @@ astcopy(int rfd, int wfd, off_t n)
 
 	static int	bufsiz;
 	static char*	buf;
+#ifdef KERNSIZE
+	static int	kernrfd = -1;
+	static int	kernwfd = -1;
+	static int	kernbad;
+#endif
 
 	if (n <= 0 || n >= BUFSIZ * 2)
 	{
+#ifdef KERNSIZE
+		/*
+		 * let the kernel move the data without a user space copy;
+		 * 0 may be returned for pseudo files that are not empty,
+		 * so the read() below has the final say on end of file;
+		 * a method that does not apply is not retried until the
+		 * next copy, which starts with another fd pair or after
+		 * end of file or an error
+		 */
+
+		if (rfd != kernrfd || wfd != kernwfd)
+		{
+			kernrfd = rfd;
+			kernwfd = wfd;
+			kernbad = 0;
+		}
+		c = (n <= 0 || n > KERNSIZE) ? KERNSIZE : n;
+#if _lib_copy_file_range
+		if (!(kernbad & KERN_RANGE))
+		{
+			if ((pos = copy_file_range(rfd, NiL, wfd, NiL, (size_t)c, 0)) > 0)
+				return(pos);
+			if (pos < 0)
+			{
+				if (!unsupported(errno))
+				{
+					c = -1;
+					goto done;
+				}
+				kernbad |= KERN_RANGE;
+			}
+		}
+#endif
+#if _lib_sendfile_linux
+		if (!(kernbad & KERN_SENDFILE))
+		{
+			if ((pos = sendfile(wfd, rfd, NiL, (size_t)c)) > 0)
+				return(pos);
+			if (pos < 0)
+			{
+				if (!unsupported(errno))
+				{
+					c = -1;
+					goto done;
+				}
+				kernbad |= KERN_SENDFILE;
+			}
+		}
+#endif
+#if _lib_splice
+		if (!(kernbad & KERN_SPLICE))
+		{
+			if ((pos = splice(rfd, NiL, wfd, NiL, (size_t)c, SPLICE_F_MOVE)) > 0)
+				return(pos);
+			if (pos < 0)
+			{
+				if (!unsupported(errno))
+				{
+					c = -1;
+					goto done;
+				}
+				kernbad |= KERN_SPLICE;
+			}
+		}
+#endif
+#endif
 #if MAPSIZE
 		if (!fstat(rfd, &st) && S_ISREG(st.st_mode) && (pos = lseek(rfd, (off_t)0, 1)) != ((off_t)-1))
 		{
-			if (pos >= st.st_size) return(0);
+			if (pos >= st.st_size)
+			{
+				c = 0;
+				goto done;
+			}
 			mapsize = st.st_size - pos;
 			if (mapsize > MAPSIZE) mapsize = (mapsize > n && n > 0) ? n : MAPSIZE;
 			if (mapsize >= BUFSIZ * 2 && (mapbuf = (char*)mmap(NiL, mapsize, PROT_READ, MAP_SHARED, rfd, pos)) != ((caddr_t)-1))
 			{
-				if (write(wfd, mapbuf, mapsize) != mapsize || lseek(rfd, mapsize, 1) == ((off_t)-1)) return(-1);
+				if (write(wfd, mapbuf, mapsize) != mapsize || lseek(rfd, mapsize, 1) == ((off_t)-1))
+				{
+					c = -1;
+					goto done;
+				}
 				munmap((caddr_t)mapbuf, mapsize);
 				return(mapsize);
 			}
 		}
 #endif
-		if (n <= 0) n = BUFSIZ;
+		if (n <= 0) n = COPYSIZE;
 	}
 	if (n > bufsiz)
 	{
 		if (buf) free(buf);
 		bufsiz = roundof(n, BUFSIZ);
-		if (!(buf = newof(0, char, bufsiz, 0))) return(-1);
+		if (!(buf = newof(0, char, bufsiz, 0)))
+		{
+			c = -1;
+			goto done;
+		}
 	}
 	if ((c = read(rfd, buf, (size_t)n)) > 0 && write(wfd, buf, (size_t)c) != c) c = -1;
+ done:
+#ifdef KERNSIZE
+	if (c <= 0)
+		kernrfd = kernwfd = -1;
+#endif
 	return(c);
 }
@@ -26,16 +26,17 @@
 #include <ast.h>
 #include <regex.h>
 
-#define CACHE		8		/* default # cached re's	*/
+#define CACHE		64		/* default # cached re's	*/
 #define ROUND		64		/* pattern buffer size round	*/
 
-typedef unsigned long Key_t;
-
 typedef struct Cache_s
 {
+	struct Cache_s*	next;		/* hash bucket chain		*/
+	struct Cache_s*	newer;		/* LRU list toward most recent	*/
+	struct Cache_s*	older;		/* LRU list toward least recent	*/
 	char*		pattern;
 	regex_t		re;
-	unsigned long	serial;
+	unsigned long	hash;
 	regflags_t	reflags;
 	int		keep;
 	int		size;
@@ -43,29 +44,78 @@ typedef struct Cache_s
 
 typedef struct State_s
 {
-	unsigned int	size;
-	unsigned long	serial;
+	unsigned int	size;		/* max # cached re's		*/
+	unsigned int	count;		/* # allocated entries		*/
+	unsigned int	mask;		/* hash bucket mask		*/
 	char*		locale;
-	Cache_t**	cache;
+	Cache_t**	hash;		/* hash buckets			*/
+	Cache_t		lru;		/* LRU list head		*/
 } State_t;
 
 static State_t	matchstate;
 
 /*
  * flush the cache
+ * the entries stay on the LRU list for reuse
  */
 
 static void
 flushcache(void)
 {
-	register int		i;
+	register Cache_t*	cp;
 
-	for (i = matchstate.size; i--;)
-		if (matchstate.cache[i] && matchstate.cache[i]->keep)
+	for (cp = matchstate.lru.newer; cp && cp != &matchstate.lru; cp = cp->newer)
+		if (cp->keep)
 		{
-			matchstate.cache[i]->keep = 0;
-			regfree(&matchstate.cache[i]->re);
+			cp->keep = 0;
+			regfree(&cp->re);
 		}
+	if (matchstate.hash)
+		memset(matchstate.hash, 0, (matchstate.mask + 1) * sizeof(Cache_t*));
+}
+
+/*
+ * (re)size the hash table to at least 2*size buckets
+ * the cache must be flushed first
+ */
+
+static int
+hashsize(unsigned int size)
+{
+	unsigned int	n;
+
+	for (n = 16; n < 2 * size; n <<= 1);
+	if (n > matchstate.mask + 1 || !matchstate.hash)
+	{
+		if (!(matchstate.hash = newof(matchstate.hash, Cache_t*, n, 0)))
+		{
+			matchstate.mask = 0;
+			return -1;
+		}
+		matchstate.mask = n - 1;
+		memset(matchstate.hash, 0, n * sizeof(Cache_t*));
+	}
+	return 0;
+}
+
+/*
+ * move cp to the most recently used end of the LRU list
+ */
+
+static void
+touch(register Cache_t* cp)
+{
+	if (cp->newer)
+	{
+		if (cp->newer == &matchstate.lru)
+			return;
+		cp->newer->older = cp->older;
+		cp->older->newer = cp->newer;
+	}
+	cp->older = matchstate.lru.older;
+	cp->newer = &matchstate.lru;
+	cp->older->newer = cp;
+	matchstate.lru.older = cp;
 }
 
 /*
@@ -76,12 +126,11 @@ regex_t*
 regcache(const char* pattern, regflags_t reflags, int* status)
 {
 	register Cache_t*	cp;
+	register Cache_t**	pp;
+	register const char*	t;
+	register unsigned long	h;
 	register int		i;
 	char*			s;
-	int			empty;
-	int			unused;
-	int			old;
-	Key_t			key;
 
 	/*
 	 * 0 pattern flushes the cache and reflags>0 extends cache
@@ -93,24 +142,27 @@ regcache(const char* pattern, regflags_t reflags, int* status)
 		i = 0;
 		if (reflags > matchstate.size)
 		{
-			if (matchstate.cache = newof(matchstate.cache, Cache_t*, reflags, 0))
-				matchstate.size = reflags;
-			else
+			if (hashsize(reflags))
 			{
 				matchstate.size = 0;
 				i = 1;
 			}
+			else
+				matchstate.size = reflags;
 		}
 		if (status)
 			*status = i;
 		return 0;
 	}
-	if (!matchstate.cache)
+	if (!matchstate.hash)
 	{
-		if (!(matchstate.cache = newof(0, Cache_t*, CACHE, 0)))
+		if (hashsize(matchstate.size < CACHE ? CACHE : matchstate.size))
 			return 0;
-		matchstate.size = CACHE;
+		if (matchstate.size < CACHE)
+			matchstate.size = CACHE;
 	}
+	if (!matchstate.lru.newer)
+		matchstate.lru.newer = matchstate.lru.older = &matchstate.lru;
 
 	/*
 	 * flush the cache if the locale changed
@@ -128,67 +180,69 @@ regcache(const char* pattern, regflags_t reflags, int* status)
 	 * check if the pattern is in the cache
 	 */
 
-	for (i = 0; i < sizeof(key) && pattern[i]; i++)
-		((char*)&key)[i] = pattern[i];
-	for (; i < sizeof(key); i++)
-		((char*)&key)[i] = 0;
-	empty = unused = -1;
-	old = 0;
-	for (i = matchstate.size; i--;)
-		if (!matchstate.cache[i])
-			empty = i;
-		else if (!matchstate.cache[i]->keep)
-			unused = i;
-		else if (*(Key_t*)matchstate.cache[i]->pattern == key && !strcmp(matchstate.cache[i]->pattern, pattern) && matchstate.cache[i]->reflags == reflags)
+	h = reflags;
+	for (t = pattern; *t; t++)
+		h = (h ^ (unsigned char)*t) * 0x01000193;
+	pp = &matchstate.hash[(h ^ (h >> 16)) & matchstate.mask];
+	for (cp = *pp; cp; cp = cp->next)
+		if (cp->hash == h && cp->reflags == reflags && !strcmp(cp->pattern, pattern))
 			break;
-		else if (!matchstate.cache[old] || matchstate.cache[old]->serial > matchstate.cache[i]->serial)
-			old = i;
-	if (i < 0)
+	if (!cp)
 	{
-		if (unused < 0)
-		{
-			if (empty < 0)
-				unused = old;
-			else
-				unused = empty;
-		}
-		if (!(cp = matchstate.cache[unused]) && !(cp = matchstate.cache[unused] = newof(0, Cache_t, 1, 0)))
+		/*
+		 * reuse the least recently used entry once the cache is full
+		 */
+
+		if (matchstate.count < matchstate.size || (cp = matchstate.lru.older) == &matchstate.lru)
 		{
-			if (status)
-				*status = REG_ESPACE;
-			return 0;
+			if (!(cp = newof(0, Cache_t, 1, 0)))
+			{
+				if (status)
+					*status = REG_ESPACE;
+				return 0;
+			}
+			matchstate.count++;
 		}
-		if (cp->keep)
+		else if (cp->keep)
 		{
+			Cache_t**	op;
+
+			for (op = &matchstate.hash[(cp->hash ^ (cp->hash >> 16)) & matchstate.mask]; *op; op = &(*op)->next)
+				if (*op == cp)
+				{
+					*op = cp->next;
+					break;
+				}
 			cp->keep = 0;
 			regfree(&cp->re);
 		}
-		if ((i = strlen(pattern) + 1) > cp->size)
+		touch(cp);
+		if ((i = t - pattern + 1) > cp->size)
 		{
 			cp->size = roundof(i, ROUND);
 			if (!(cp->pattern = newof(cp->pattern, char, cp->size, 0)))
 			{
+				cp->size = 0;
 				if (status)
 					*status = REG_ESPACE;
 				return 0;
 			}
 		}
 		strcpy(cp->pattern, pattern);
-		while (++i < sizeof(Key_t))
-			cp->pattern[i] = 0;
-		pattern = (const char*)cp->pattern;
-		if (i = regcomp(&cp->re, pattern, reflags))
+		if (i = regcomp(&cp->re, cp->pattern, reflags))
 		{
 			if (status)
 				*status = i;
 			return 0;
 		}
 		cp->keep = 1;
+		cp->hash = h;
 		cp->reflags = reflags;
+		cp->next = *pp;
+		*pp = cp;
 	}
 	else
-		cp = matchstate.cache[i];
-	cp->serial = ++matchstate.serial;
+		touch(cp);
 	if (status)
 		*status = 0;
 	return &cp->re;
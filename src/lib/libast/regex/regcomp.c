@@ -3005,10 +3005,32 @@ bmtrie(Cenv_t* env, Rex_t* a, unsigned char* v, Trie_node_t* x, int n, int m, Bm
 	return b;
 }
 
+/*
+ * rank c by how seldom it occurs in text -- higher is rarer
+ */
+
+static int
+rarity(int c)
+{
+	static const char	common[] = " etaoinsrhldcumfpgwybvkxjqz";
+	char*			s;
+
+	if (c && (s = strchr(common, c)))
+		return s - common;
+	if (isdigit(c))
+		return 30;
+	if (isupper(c))
+		return 40;
+	if (ispunct(c))
+		return 45;
+	return 50;
+}
+
 /*
  * rewrite the expression tree for some special cases
  * 1. it is a null expression - illegal
  * 2. max length fixed string found -- use BM algorithm
+ *    (unless it is at a bounded offset from a left anchor)
  * 3. it begins with an unanchored string - use KMP algorithm
  * 0 returned on success
  */		
@@ -3041,6 +3063,15 @@ special(Cenv_t* env, regex_t* p)
 			else
 				x = 0;
 		}
+		if ((x || t) && e->type == REX_BEG && !(env->flags & REG_NEWLINE))
+		{
+			y = x ? x : t;
+			for (a = e->next; a && a != y; a = a->next)
+				if (a->type != REX_STRING && (a->type != REX_DOT && a->type != REX_CLASS && a->type != REX_COLL_CLASS && a->type != REX_ONECHAR || a->hi == RE_DUP_INF))
+					break;
+			if (a == y)
+				x = t = 0;
+		}
 		if (x || t)
 		{
 			Bm_mask_t**	mask;
@@ -3066,7 +3097,7 @@ special(Cenv_t* env, regex_t* p)
 			}
 			if (!(q = (size_t*)alloc(env->disc, 0, (n + 1) * sizeof(size_t))))
 				return 1;
-			if (!(a = node(env, REX_BM, 0, 0, n * (sizeof(Bm_mask_t*) + (UCHAR_MAX + 1) * sizeof(Bm_mask_t)) + (UCHAR_MAX + n + 2) * sizeof(size_t))))
+			if (!(a = node(env, REX_BM, 0, 0, n * (sizeof(Bm_mask_t*) + (UCHAR_MAX + 1) * sizeof(Bm_mask_t)) + (UCHAR_MAX + n + 2) * sizeof(size_t) + n)))
 			{
 				alloc(env->disc, q, 0);
 				return 1;
@@ -3093,7 +3124,23 @@ special(Cenv_t* env, regex_t* p)
 				h += UCHAR_MAX + 1;
 			}
 			if (x)
+			{
 				bmstr(env, a, x->re.string.base, n, 1);
+				if (!(a->flags & REG_ICASE))
+				{
+					/*
+					 * an exact literal is found by memchr() on its
+					 * rarest byte, then verified with memcmp()
+					 */
+
+					v = a->re.bm.base = (unsigned char*)&a->re.bm.fail[n + 1];
+					memcpy(v, x->re.string.base, n);
+					for (i = j = 0; i < n; i++)
+						if (rarity(v[i]) > rarity(v[j]))
+							j = i;
+					a->re.bm.rare = j;
+				}
+			}
 			else
 			{
 				v = (unsigned char*)q;
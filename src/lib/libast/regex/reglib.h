@@ -343,6 +343,8 @@ typedef struct Bm_s
 	ssize_t		left;
 	ssize_t		right;
 	size_t		complete;
+	unsigned char*	base;		/* memchr() scan literal or 0	*/
+	size_t		rare;		/* base offset of memchr() byte	*/
 } Bm_t;
 
 typedef struct String_s
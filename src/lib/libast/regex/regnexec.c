@@ -1922,6 +1922,57 @@ regnexec_20120528(const regex_t* p, const char* s, size_t len, size_t nmatch, re
 			size_t			x;
 
 			DEBUG_TEST(0x0080,(sfprintf(sfstdout, "AHA#%04d REX_BM len=%d right=%d left=%d size=%d %d %d\n", __LINE__, len, e->re.bm.right, e->re.bm.left, e->re.bm.size, index, mid)),(0));
+			if (e->re.bm.base)
+			{
+				register unsigned char*	base = e->re.bm.base;
+				register size_t		size = e->re.bm.size;
+				register size_t		rare = e->re.bm.rare;
+				unsigned char*		v;
+
+				/*
+				 * index is the offset of the last literal byte of
+				 * the next candidate; memchr() is usually vectorized
+				 */
+
+				for (;;)
+				{
+					if (index >= mid || !(v = (unsigned char*)memchr(buf + index - size + 1 + rare, base[rare], mid - index)))
+						goto done;
+					index = v - buf - rare;
+					if (memcmp(buf + index, base, size))
+					{
+						index += size;
+						continue;
+					}
+					if (e->re.bm.back < 0)
+						goto possible;
+					if (advance)
+					{
+						i = index - e->re.bm.back;
+						s += i;
+						if (env->stack)
+							env->best[0].rm_so += i;
+						goto possible;
+					}
+					x = index;
+					if (index < e->re.bm.back)
+						index = 0;
+					else
+						index -= e->re.bm.back;
+					while (index <= x)
+					{
+						if ((i = parse(env, e->next, &env->done, buf + index)) != NONE)
+						{
+							if (env->stack)
+								env->best[0].rm_so = index;
+							n = env->nsub;
+							goto hit;
+						}
+						index++;
+					}
+					index += size - 1;
+				}
+			}
 			for (;;)
 			{
 				while (index < mid)
@@ -128,7 +128,8 @@ int _sfsetpool(Sfio_t* f)
 			p->sf = p->array;
 		}
 		else	/* allocate a larger array */
-		{	n = (p->sf != p->array ? p->s_sf : (p->s_sf/4 + 1)*4) + 4;
+		{	n = (p->sf != p->array ? p->s_sf : (p->s_sf/4 + 1)*4);
+			n += n/2 + 4;	/* grow geometrically to avoid quadratic copying */
 			if(!(array = (Sfio_t**)malloc(n*sizeof(Sfio_t*))) )
 				goto done;
 
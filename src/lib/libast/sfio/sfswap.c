@@ -26,6 +26,27 @@
 **	Written by Kiem-Phong Vo.
 */
 
+/*	Find the index of f in its pool, or -1. Long-lived streams such as the
+**	standard streams and stkstd sit near the front of a large pool while
+**	recently opened ones sit near the end, so search from both ends at once.
+*/
+static int poolindex(Sfio_t* f)
+{
+	reg Sfio_t**	sf;
+	reg int		lo, hi;
+
+	if(!f->pool)
+		return -1;
+	sf = f->pool->sf;
+	for(lo = 0, hi = f->pool->n_sf-1; lo <= hi; ++lo, --hi)
+	{	if(sf[hi] == f)
+			return hi;
+		if(sf[lo] == f)
+			return lo;
+	}
+	return -1;
+}
+
 Sfio_t* sfswap(reg Sfio_t* f1, reg Sfio_t* f2)
 {
 	Sfio_t	tmp;
@@ -64,16 +85,8 @@ Sfio_t* sfswap(reg Sfio_t* f1, reg Sfio_t* f2)
 		f2mode = SF_AVAIL;
 	}
 
-	if(!f1->pool)
-		f1pool = -1;
-	else for(f1pool = f1->pool->n_sf-1; f1pool >= 0; --f1pool)
-		if(f1->pool->sf[f1pool] == f1)
-			break;
-	if(!f2->pool)
-		f2pool = -1;
-	else for(f2pool = f2->pool->n_sf-1; f2pool >= 0; --f2pool)
-		if(f2->pool->sf[f2pool] == f2)
-			break;
+	f1pool = poolindex(f1);
+	f2pool = poolindex(f2);
 
 	f1flags = f1->flags;
 	f2flags = f2->flags;
@@ -113,6 +113,38 @@ regress(Sfio_t* sp, ssize_t n, int f)
 	return r;
 }
 
+#if _lib_copy_file_range || _lib_sendfile_linux || _lib_splice
+
+/*
+ * copy the unread file stream ip to op with astcopy(), which
+ * moves the data inside the kernel where possible
+ * 1 returned if op is not a plain file descriptor stream
+ */
+
+static int
+fdmove(Sfio_t* ip, Sfio_t* op)
+{
+	Sfdisc_t*	dp;
+	off_t		n;
+	int		fd;
+
+	if ((sfset(op, 0, 0) & SF_STRING) || (fd = sffileno(op)) < 0)
+		return 1;
+	for (dp = sfdisc(op, (Sfdisc_t*)op); dp; dp = dp->disc)
+		if (dp->readf || dp->writef || dp->seekf)
+			return 1;
+	if (sfsync(op))
+		return -1;
+	while ((n = astcopy(sffileno(ip), fd, 0)) > 0);
+	if (n < 0)
+		return -1;
+	if ((n = lseek(fd, (off_t)0, SEEK_CUR)) >= 0)
+		sfseek(op, (Sfoff_t)n, SEEK_SET);
+	return 0;
+}
+
+#endif
+
 /*
  * called for any special output processing
  */
@@ -533,6 +565,10 @@ b_cat(int argc, char** argv, Shbltin_t* context)
 			sfsetbuf(fp, (void*)fp, -1);
 		if (dovcat)
 			n = vcat(states, fp, sfstdout, reserve, flags);
+#if _lib_copy_file_range || _lib_sendfile_linux || _lib_splice
+		else if (fp != sfstdin && !(flags&(D_FLAG|d_FLAG)) && (n = fdmove(fp, sfstdout)) <= 0)
+			;
+#endif
 		else if (sfmove(fp, sfstdout, SF_UNBOUND, -1) >= 0 && sfeof(fp))
 			n = 0;
 		else
@@ -24,7 +24,7 @@
  */
 
 static const char usage[] =
-"[-?\n@(#)$Id: sum (AT&T Research) 2012-04-20 $\n]"
+"[-?\n@(#)$Id: sum (ksh 93u+m) 2022-11-01 $\n]"
 "[--catalog?" ERROR_CATALOG "]"
 "[+NAME?cksum,md5sum,sum - print file checksum and block count]"
 "[+DESCRIPTION?\bsum\b lists the checksum, and for most methods the block"
@@ -65,6 +65,9 @@ static const char usage[] =
 "}"
 "[h:header?Print the checksum method as the first output line. Used with"
 "	\b--check\b and \b--permissions\b.]"
+"[j:jobs?Checksum up to \ajobs\a files at a time in separate processes."
+"	The output is listed in the same order as for one job. \b0\b means"
+"	one job per online processor. Ignored for \b--total\b.]#[jobs:=1]"
 "[l:list?Each \afile\a is interpreted as a list of files, one per line,"
 "	that is checksummed.]"
 "[p:permissions?If \b--check\b is not specified then list the file"
@@ -112,20 +115,42 @@ static const char usage[] =
 #include <modex.h>
 #include <fts.h>
 #include <error.h>
+#include <sig.h>
+#include <wait.h>
+
+#define JOBQUEUE	2		/* files queued per job		*/
+#define BIGBUF		(1024*1024)	/* buffer size for big files	*/
+#define BIGMIN		(1024*1024)	/* smallest big file		*/
+
+typedef struct Job_s			/* --jobs process		*/
+{
+	Sfio_t*		op;		/* files to checksum		*/
+	Sfio_t*		ip;		/* job output			*/
+	pid_t		pid;		/* job process ID		*/
+} Job_t;
 
 typedef struct State_s			/* program state		*/
 {
 	int		all;		/* list all items		*/
 	Sfio_t*		check;		/* check previous output	*/
+	Sfio_t*		err;		/* job error messages		*/
+	int		errors;		/* job error count for a file	*/
+	void		(*exit)(int);	/* saved error_info.exit	*/
 	int		flags;		/* sumprint() SUM_* flags	*/
 	gid_t		gid;		/* caller GID			*/
+	unsigned long	got;		/* job outputs listed		*/
 	int		header;		/* list method on output	*/
+	Job_t*		job;		/* --jobs processes		*/
+	int		jobs;		/* number of --jobs processes	*/
 	int		list;		/* list file name too		*/
+	char*		method;		/* --check method name		*/
 	Sum_t*		oldsum;		/* previous sum method		*/
+	Sfio_t*		op;		/* job output			*/
 	int		permissions;	/* include mode,user,group	*/
 	int		haveperm;	/* permissions in the input	*/
 	int		recursive;	/* recursively descend dirs	*/
 	size_t		scale;		/* scale override		*/
+	unsigned long	sent;		/* files sent to jobs		*/
 	unsigned long	size;		/* combined size of all files	*/
 	int		silent;		/* silent check, 0 exit if ok	*/
 	int		(*sort)(FTSENT* const*, FTSENT* const*);
@@ -134,8 +159,12 @@ typedef struct State_s			/* program state		*/
 	int		total;		/* list totals only		*/
 	uid_t		uid;		/* caller UID			*/
 	int		warn;		/* invalid check line warnings	*/
+	ssize_t		(*write)(int, const void*, size_t); /* saved error_info.write */
 } State_t;
 
+static State_t*	jobstate;
+
+static void	jobclose(State_t*, int);
 static void	verify(State_t*, char*, char*, Sfio_t*);
 
 /*
@@ -220,8 +249,18 @@ pr(State_t* state, Sfio_t* op, Sfio_t* ip, char* file, int perm, struct stat* st
 			sumblock(state->sum, "\r", 1);
 	}
 	else
+	{
+		/*
+		 * read big regular files with fewer system calls; this is
+		 * not done with mmap(2) as a file truncated while it is
+		 * being summed would then raise SIGBUS
+		 */
+
+		if (ip != sfstdin && !fstat(sffileno(ip), &ss) && S_ISREG(ss.st_mode) && ss.st_size >= BIGMIN)
+			sfsetbuf(ip, NiL, BIGBUF);
 		while (p = sfreserve(ip, SF_UNBOUND, 0))
 			sumblock(state->sum, p, sfvalue(ip));
+	}
 	if (sfvalue(ip))
 		error(ERROR_SYSTEM|2, "%s: read error", file);
 	sumdone(state->sum);
@@ -235,7 +274,7 @@ pr(State_t* state, Sfio_t* op, Sfio_t* ip, char* file, int perm, struct stat* st
 				if (!st && fstat(sffileno(ip), st = &ss))
 					error(ERROR_SYSTEM|2, "%s: cannot stat", file);
 				else
-					sfprintf(sfstdout, " %04o %s %s",
+					sfprintf(op, " %04o %s %s",
 						modex(st->st_mode & S_IPERM),
 						(st->st_uid != state->uid && ((st->st_mode & S_ISUID) || (st->st_mode & S_IRUSR) && !(st->st_mode & (S_IRGRP|S_IROTH)) || (st->st_mode & S_IXUSR) && !(st->st_mode & (S_IXGRP|S_IXOTH)))) ? fmtuid(st->st_uid) : "-",
 						(st->st_gid != state->gid && ((st->st_mode & S_ISGID) || (st->st_mode & S_IRGRP) && !(st->st_mode & S_IROTH) || (st->st_mode & S_IXGRP) && !(st->st_mode & S_IXOTH))) ? fmtgid(st->st_gid) : "-");
@@ -247,6 +286,310 @@ pr(State_t* state, Sfio_t* op, Sfio_t* ip, char* file, int perm, struct stat* st
 	}
 }
 
+/*
+ * compute and print sum on file path listed as file
+ */
+
+static void
+sum(State_t* state, Sfio_t* op, const char* path, char* file, struct stat* st)
+{
+	Sfio_t*		sp;
+
+	if (sp = openfile(path, "rb"))
+	{
+		pr(state, op, sp, file, state->permissions, st, NiL);
+		closefile(sp);
+	}
+}
+
+/*
+ * list the output of the oldest file sent to the --jobs processes
+ */
+
+static void
+collect(State_t* state)
+{
+	register Sfio_t*	ip = state->job[state->got++ % state->jobs].ip;
+	register char*		s;
+	register ssize_t	n;
+
+	if (!(s = sfgetr(ip, 0, 0)))
+		goto bad;
+	sfwrite(sfstdout, s, sfvalue(ip) - 1);
+	if (!(s = sfgetr(ip, 0, 0)))
+		goto bad;
+	if ((n = sfvalue(ip) - 2) > 0)
+	{
+		sfsync(sfstdout);
+		sfwrite(sfstderr, s, n);
+		sfsync(sfstderr);
+	}
+	if (s[n] != '0')
+		error_info.errors++;
+	return;
+ bad:
+	jobclose(state, 0);
+	error(3, "checksum job terminated");
+	UNREACHABLE();
+}
+
+/*
+ * error_info.write for the --jobs parent
+ * messages are listed after the output of the files sent so far
+ */
+
+static ssize_t
+jobwrite(int fd, const void* buf, size_t n)
+{
+	while (jobstate->got < jobstate->sent)
+		collect(jobstate);
+	return (*jobstate->write)(fd, buf, n);
+}
+
+/*
+ * error_info.exit for the --jobs parent
+ */
+
+static void
+jobexit(int code)
+{
+	void	(*exitf)(int) = jobstate->exit;
+
+	jobclose(jobstate, 1);
+	(*exitf)(code);
+}
+
+/*
+ * error_info.write for a --jobs process
+ * messages are saved for the parent
+ */
+
+static ssize_t
+childwrite(int fd, const void* buf, size_t n)
+{
+	return sfwrite(jobstate->err, buf, n);
+}
+
+/*
+ * end the output for a file in a --jobs process
+ */
+
+static void
+childdone(State_t* state, Sfio_t* op)
+{
+	sfputc(op, 0);
+	sfputr(op, sfstruse(state->err), error_info.errors != state->errors ? '1' : '0');
+	sfputc(op, 0);
+	sfsync(op);
+}
+
+/*
+ * error_info.exit for a --jobs process
+ */
+
+static void
+childexit(int code)
+{
+	childdone(jobstate, jobstate->op);
+	_exit(code);
+}
+
+/*
+ * --jobs process main loop
+ * checksum the files sent on fd and write the output to op
+ */
+
+static void
+child(State_t* state, int fd, Sfio_t* op)
+{
+	Sfio_t*		ip;
+	char*		s;
+	char*		path;
+	char*		file;
+	char*		method;
+	int		check;
+
+	signal(SIGINT, SIG_DFL);
+	signal(SIGQUIT, SIG_DFL);
+	signal(SIGTERM, SIG_DFL);
+	signal(SIGPIPE, SIG_DFL);
+	state->jobs = 0;
+	state->op = op;
+	state->oldsum = state->sum;
+	method = 0;
+	if (!(ip = sfnew(NiL, NiL, SF_UNBOUND, fd, SF_READ)) || !(state->err = sfstropen()))
+		_exit(1);
+	error_info.write = childwrite;
+	error_info.exit = childexit;
+	while (s = sfgetr(ip, 0, 1))
+	{
+		if ((check = *s == 'c') && (!(s = sfgetr(ip, 0, 1)) || !streq(s, state->sum->name) && (!(method = strdup(s)) || !(state->sum = sumopen(method)))))
+			_exit(1);
+		if (!(s = sfgetr(ip, 0, 1)) || !(path = strdup(s)) || !(s = sfgetr(ip, 0, 1)) || !(file = strdup(s)))
+			_exit(1);
+		state->errors = error_info.errors;
+		if (check)
+			verify(state, file, path, state->check);	/* check line, check file */
+		else
+			sum(state, op, path, file, NiL);
+		childdone(state, op);
+		free(path);
+		free(file);
+		if (method)
+		{
+			if (state->sum != state->oldsum)
+				sumclose(state->sum);
+			state->sum = state->oldsum;
+			free(method);
+			method = 0;
+		}
+	}
+	_exit(0);
+}
+
+/*
+ * start the --jobs processes
+ */
+
+static void
+jobopen(State_t* state)
+{
+	register int	i;
+	register int	j;
+	pid_t		pid;
+	int		ifd[2];
+	int		ofd[2];
+	Sfio_t*		op;
+
+	if (!(state->job = newof(0, Job_t, state->jobs, 0)))
+	{
+		error(ERROR_SYSTEM|2, "out of space [jobs]");
+		state->jobs = 0;
+		return;
+	}
+	sfsync(sfstdout);
+	sfsync(sfstderr);
+	for (i = 0; i < state->jobs; i++)
+	{
+		if (pipe(ifd))
+			break;
+		if (pipe(ofd))
+		{
+			close(ifd[0]);
+			close(ifd[1]);
+			break;
+		}
+		if (!(pid = fork()))
+		{
+			for (j = 0; j < i; j++)
+			{
+				sfclose(state->job[j].op);
+				sfclose(state->job[j].ip);
+			}
+			close(ifd[1]);
+			close(ofd[0]);
+			jobstate = state;
+			if (!(op = sfnew(NiL, NiL, SF_UNBOUND, ofd[1], SF_WRITE)))
+				_exit(1);
+			child(state, ifd[0], op);
+		}
+		close(ifd[0]);
+		close(ofd[1]);
+		if (pid < 0 || !(state->job[i].op = sfnew(NiL, NiL, SF_UNBOUND, ifd[1], SF_WRITE)) || !(state->job[i].ip = sfnew(NiL, NiL, SF_UNBOUND, ofd[0], SF_READ)))
+		{
+			if (pid > 0)
+				kill(pid, SIGTERM);
+			if (state->job[i].op)
+				sfclose(state->job[i].op);
+			else
+				close(ifd[1]);
+			close(ofd[0]);
+			break;
+		}
+		state->job[i].pid = pid;
+	}
+	if (!(state->jobs = i))
+	{
+		error(ERROR_SYSTEM|1, "cannot start jobs");
+		free(state->job);
+		state->job = 0;
+		return;
+	}
+	jobstate = state;
+	state->exit = error_info.exit;
+	state->write = error_info.write;
+	error_info.exit = jobexit;
+	error_info.write = jobwrite;
+}
+
+/*
+ * list the pending job output if drain!=0 and stop the --jobs processes
+ */
+
+static void
+jobclose(State_t* state, int drain)
+{
+	register int	i;
+
+	if (!state->job)
+		return;
+	if (drain)
+		while (state->got < state->sent)
+			collect(state);
+	if (jobstate == state)
+	{
+		error_info.exit = state->exit;
+		error_info.write = state->write;
+		jobstate = 0;
+	}
+	for (i = 0; i < state->jobs; i++)
+	{
+		if (!drain)
+			kill(state->job[i].pid, SIGTERM);
+		sfclose(state->job[i].op);
+		sfclose(state->job[i].ip);
+		waitpid(state->job[i].pid, NiL, 0);
+	}
+	free(state->job);
+	state->job = 0;
+	state->jobs = 0;
+}
+
+/*
+ * send a file to the next --jobs process
+ * for a --check line path is the check file and file is the line
+ */
+
+static void
+jobsend(State_t* state, int check, const char* path, const char* file)
+{
+	Sfio_t*		op;
+	Sig_handler_t	handler;
+	int		r;
+
+	if (state->sent - state->got >= JOBQUEUE * state->jobs)
+		collect(state);
+	op = state->job[state->sent++ % state->jobs].op;
+	handler = signal(SIGPIPE, SIG_IGN);
+	if (check)
+	{
+		sfputr(op, "c", 0);
+		sfputr(op, state->sum->name, 0);
+	}
+	else
+		sfputr(op, "f", 0);
+	sfputr(op, path, 0);
+	sfputr(op, file, 0);
+	r = sfsync(op);
+	signal(SIGPIPE, handler);
+	if (r < 0)
+	{
+		jobclose(state, 0);
+		error(3, "checksum job terminated");
+		UNREACHABLE();
+	}
+}
+
 /*
  * verify previous sum output
  */
@@ -268,6 +611,11 @@ verify(State_t* state, register char* s, char* check, Sfio_t* rp)
 		return;
 	if (t = strchr(s, ' '))
 	{
+		if (state->jobs)
+		{
+			jobsend(state, 1, check, s);
+			return;
+		}
 		if ((t - s) > 10 || !(file = strchr(t + 1, ' ')))
 			file = t;
 		*file++ = 0;
@@ -389,7 +737,10 @@ verify(State_t* state, register char* s, char* check, Sfio_t* rp)
 		s += 7;
 		if (state->sum != state->oldsum)
 			sumclose(state->sum);
-		if (!(state->sum = sumopen(s)))
+		free(state->method);
+		if (!(state->method = strdup(s)))
+			error(ERROR_SYSTEM|3, "out of space");
+		if (!(state->sum = sumopen(state->method)))
 			error(3, "%s: %s: unknown checksum method", check, s);
 	}
 	else if (streq(s, "permissions"))
@@ -409,7 +760,14 @@ list(State_t* state, register Sfio_t* lp)
 	register Sfio_t*	sp;
 
 	while (file = sfgetr(lp, '\n', 1))
-		if (sp = openfile(file, state->check ? "rt" : "rb"))
+		if (!state->check)
+		{
+			if (state->jobs)
+				jobsend(state, 0, file, file);
+			else
+				sum(state, sfstdout, file, file, NiL);
+		}
+		else if (sp = openfile(file, "rt"))
 		{
 			pr(state, sfstdout, sp, file, state->permissions, NiL, state->check);
 			closefile(sp);
@@ -479,6 +837,10 @@ b_cksum(int argc, register char** argv, Shbltin_t* context)
 		case 'h':
 			state.header = 1;
 			continue;
+		case 'j':
+			if ((state.jobs = opt_info.num) <= 0)
+				state.jobs = (int)strtol(astconf("NPROCESSORS_ONLN", NiL, NiL), NiL, 0);
+			continue;
 		case 'l':
 			state.list = 1;
 			continue;
@@ -573,6 +935,10 @@ b_cksum(int argc, register char** argv, Shbltin_t* context)
 		if (state.permissions)
 			sfprintf(sfstdout, "permissions\n");
 	}
+	if (state.jobs > 1 && !state.total && (state.list || state.check || state.recursive || *argv))
+		jobopen(&state);
+	else
+		state.jobs = 0;
 	if (state.list)
 	{
 		if (*argv)
@@ -607,7 +973,9 @@ b_cksum(int argc, register char** argv, Shbltin_t* context)
 					fts_set(NiL, ent, FTS_FOLLOW);
 				break;
 			case FTS_F:
-				if (sp = openfile(ent->fts_accpath, "rb"))
+				if (state.jobs && !state.check)
+					jobsend(&state, 0, ent->fts_path, ent->fts_path);
+				else if (sp = openfile(ent->fts_accpath, "rb"))
 				{
 					pr(&state, sfstdout, sp, ent->fts_path, state.permissions, ent->fts_statp, state.check);
 					closefile(sp);
@@ -628,11 +996,13 @@ b_cksum(int argc, register char** argv, Shbltin_t* context)
 			}
 		fts_close(fts);
 	}
+	jobclose(&state, !sh_checksig(context));
 	if (state.total)
 	{
 		sumprint(state.sum, sfstdout, state.flags|SUM_TOTAL|SUM_SCALE, state.scale);
 		sfputc(sfstdout, '\n');
 	}
 	sumclose(state.sum);
+	free(state.method);
 	return error_info.errors != 0;
 }
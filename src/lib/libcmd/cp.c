@@ -240,8 +240,12 @@ visit(State_t* state, register FTSENT* ent)
 	char*		s;
 	char*		e;
 	char*		protection;
+#if _lib_copy_file_range || _lib_sendfile_linux || _lib_splice
+	off_t		z;
+#else
 	Sfio_t*		ip;
 	Sfio_t*		op;
+#endif
 	FTS*		fts;
 	FTSENT*		sub;
 	struct stat	st;
@@ -590,6 +594,19 @@ visit(State_t* state, register FTSENT* ent)
 			}
 			else if (ent->fts_statp->st_size > 0)
 			{
+#if _lib_copy_file_range || _lib_sendfile_linux || _lib_splice
+				/*
+				 * astcopy() moves the data inside the kernel,
+				 * sharing extents on file systems with reflinks
+				 */
+
+				while ((z = astcopy(rfd, wfd, 0)) > 0);
+				n = z < 0 ? 3 : 0;
+				if (state->sync && fsync(wfd) || close(wfd))
+					n |= 2;
+				if (close(rfd))
+					n |= 1;
+#else
 				if (!(ip = sfnew(NiL, NiL, SF_UNBOUND, rfd, SF_READ)))
 				{
 					error(ERROR_SYSTEM|2, "%s: %s read stream error", ent->fts_path, state->path);
@@ -613,6 +630,7 @@ visit(State_t* state, register FTSENT* ent)
 					n |= 2;
 				if (sfclose(ip))
 					n |= 1;
+#endif
 				if (n)
 				{
 					error(ERROR_SYSTEM|2, "%s: %s %s error", ent->fts_path, state->path, n == 1 ? ERROR_translate(0, 0, 0, "read") : n == 2 ? ERROR_translate(0, 0, 0, "write") : ERROR_translate(0, 0, 0, "io"));
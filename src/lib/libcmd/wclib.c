@@ -50,6 +50,21 @@
 #define mbc(c)		((c)&WC_MB)
 #define spc(c)		((c)&WC_SP)
 
+/*
+ * SWAR (SIMD within a register) macros that test the 8 bytes of x at once
+ * zero(x) has the high bit set in each byte that is 0
+ * space(x) has the high bit set in each ASCII white space byte
+ * bits(x) counts the high bits set in x
+ */
+
+#define ONES		((uint64_t)0x0101010101010101)
+#define HIGH		(ONES*0x80)
+#define LOW7		(ONES*0x7f)
+#define zero(x)		(~((((x)&LOW7)+LOW7)|(x)|LOW7))
+#define range(x,a,b)	(((x)&LOW7)+ONES*(0x80-(a))&~(((x)&LOW7)+ONES*(0x80-(b)-1))&~(x)&HIGH)
+#define space(x)	(zero((x)^(ONES*' '))|range(x,'\t','\r'))
+#define bits(x)		(((((x)>>7)*ONES)>>56)&0xff)
+
 Wc_t* wc_init(int mode)
 {
 	register int	n;
@@ -105,6 +120,93 @@ static int invalid(const char *file, int nlines)
 	return nlines;
 }
 
+/*
+ * return the number of newlines in b[0..n-1]
+ */
+
+static Sfoff_t
+newlines(register const unsigned char* b, size_t n)
+{
+	register const unsigned char*	e = b + n;
+	register Sfoff_t		z = 0;
+	uint64_t			x;
+
+	for (; e - b >= 8; b += 8)
+	{
+		memcpy(&x, b, sizeof(x));
+		z += bits(zero(x ^ (ONES*'\n')));
+	}
+	while (b < e)
+		z += *b++ == '\n';
+	return z;
+}
+
+/*
+ * count the ASCII white space bytes in b[0..n-1] that end a word,
+ * given the byte before b[0] is a word byte if word!=0
+ */
+
+static Sfoff_t
+wordends(register const unsigned char* b, size_t n, int word)
+{
+	register const unsigned char*	e = b + n;
+	register Sfoff_t		z;
+	uint64_t			x;
+	uint64_t			y;
+
+	if (!n)
+		return 0;
+	z = word && isspace(*b);
+	for (b++; e - b >= 8; b += 8)
+	{
+		memcpy(&x, b, sizeof(x));
+		memcpy(&y, b - 1, sizeof(y));
+		z += bits(space(x) & ~space(y));
+	}
+	for (; b < e; b++)
+		z += isspace(*b) && !isspace(b[-1]);
+	return z;
+}
+
+/*
+ * check if b[0..n-1] is all ASCII
+ */
+
+static int
+ascii(register const unsigned char* b, size_t n)
+{
+	register const unsigned char*	e = b + n;
+	uint64_t			x;
+	uint64_t			y = 0;
+
+	for (; e - b >= 8; b += 8)
+	{
+		memcpy(&x, b, sizeof(x));
+		y |= x;
+	}
+	while (b < e)
+		y |= *b++;
+	return !(y & HIGH);
+}
+
+/*
+ * check if the byte types for wc_count() match the SWAR macros:
+ * ASCII white space for words, and words for all non-ASCII bytes
+ */
+
+static int
+swartype(Wc_t* wp)
+{
+	register int	n;
+
+	if (!(wp->mode & WC_WORDS))
+		return 1;
+	for (n = 0; n < (1<<CHAR_BIT); n++)
+		if (n < 0x80 ? (!wp->type[n] != !(n == ' ' || n >= '\t' && n <= '\r')) : (!wp->mb && wp->type[n]))
+			return 0;
+	return 1;
+}
+
 /*
  * handle UTF space characters
  */
@@ -255,22 +357,13 @@ int wc_count(Wc_t *wp, Sfio_t *fd, const char* file)
 			while ((cp = (unsigned char*)sfreserve(fd, SF_UNBOUND, 0)) && (c = sfvalue(fd)) > 0)
 			{
 				nchars += c;
-				endbuff = cp + c;
-				if (*--endbuff == '\n')
-					nlines++;
-				else
-					*endbuff = '\n';
-				for (;;)
-					if (*cp++ == '\n')
-					{
-						if (cp > endbuff)
-							break;
-						nlines++;
-					}
+				nlines += newlines(cp, c);
 			}
 		}
 		else
 		{
+			int	swar = swartype(wp);
+
 			while ((cp = buff = (unsigned char*)sfreserve(fd, SF_UNBOUND, 0)) && (c = sfvalue(fd)) > 0)
 			{
 				nchars += c;
@@ -284,6 +377,17 @@ int wc_count(Wc_t *wp, Sfio_t *fd, const char* file)
 					lasttype = c;
 					continue;
 				}
+				if (swar)
+				{
+					/* the last character is counted with the next buffer */
+					if (eol(lasttype))
+						nlines++;
+					nlines += newlines(cp, c - 1);
+					if (wp->mode & WC_WORDS)
+						nwords += wordends(cp, c, !lasttype);
+					lasttype = type[cp[c - 1]];
+					continue;
+				}
 				if (!lasttype && type[*cp])
 					nwords++;
 				lastchar = cp[--c];
@@ -338,10 +442,12 @@ int wc_count(Wc_t *wp, Sfio_t *fd, const char* file)
 		int		wasspace = 1;
 		unsigned char*	start;
 		int		flagm = 0;
+		int		swar;
 
 		lastchar = 0;
 		start = (endbuff = side) + 1;
 		xspace = iswspace(0xa0) || iswspace(0x85);
+		swar = !(wp->mode & WC_LONGEST) && swartype(wp);
 		while ((cp = buff = (unsigned char*)sfreserve(fd, SF_UNBOUND, 0)) && (c = sfvalue(fd)) > 0)
 		{
 			nbytes += c;
@@ -358,6 +464,18 @@ int wc_count(Wc_t *wp, Sfio_t *fd, const char* file)
 				endbuff = start;
 				continue;
 			}
+			if(swar && !mbc(lasttype) && !skip && !state && ascii(cp, c))
+			{
+				/* ASCII only, the last character is counted with the next buffer */
+				if(eol(lasttype))
+					nlines++;
+				nlines += newlines(cp, c - 1);
+				if(wp->mode & WC_WORDS)
+					nwords += wordends(cp, c, !lasttype);
+				lasttype = type[cp[c - 1]];
+				wasspace = 1;
+				continue;
+			}
 			lastchar = cp[--c];
 			endbuff = cp+c;
 			cp[c] = '\n';
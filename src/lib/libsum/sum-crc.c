@@ -51,6 +51,10 @@ typedef struct Crc_s
 	Crcnum_t		tabdata[256];
 	unsigned int		addsize;
 	unsigned int		rotate;
+#if _sum_x86
+	unsigned int		clmul;
+	uint64_t		fold[4];
+#endif
 } Crc_t;
 
 #define CRC(p,s,c)		(s = (s >> 8) ^ (p)->tab[(s ^ (c)) & 0xff])
@@ -112,6 +116,148 @@ Crcnum_t posix_cksum_tab[256] = {
 	0xa2f33668U, 0xbcb4666dU, 0xb8757bdaU, 0xb5365d03U, 0xb1f740b4U
 };
 
+#if _sum_x86
+
+/*
+ * carry-less multiply folding: 16 byte blocks of the message are folded
+ * into the block 128 (or, four at a time, 512) bits further on by
+ * multiplying each 64 bit half with x^n mod polynomial, and the last
+ * block is then reduced with the table; this works for any polynomial
+ * and for both bit orders
+ */
+
+#define CRC_FOLD_MIN	64
+
+#define CRC_LOAD(p)	_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p)), order)
+#define CRC_FOLD(x,k,y)	_mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11)), y)
+
+/*
+ * x^n mod polynomial, most significant bit first
+ */
+
+static Crcnum_t
+crc_xpow(unsigned int n, Crcnum_t polynomial)
+{
+	Crcnum_t	r = 1;
+
+	while (n--)
+		r = (r << 1) ^ ((r & 0x80000000) ? polynomial : 0);
+	return r;
+}
+
+static Crcnum_t
+crc_reflect(Crcnum_t x)
+{
+	Crcnum_t	r = 0;
+	int		i;
+
+	for (i = 0; i < 32; i++, x >>= 1)
+		r = (r << 1) | (x & 1);
+	return r;
+}
+
+/*
+ * crc of n bytes at b, n a multiple of 16 and at least 32
+ */
+
+static SUM_TARGET("pclmul,sse4.1") Crcnum_t
+crc_fold(Crc_t* sum, Crcnum_t c, const unsigned char* b, size_t n)
+{
+	__m128i		order;
+	__m128i		k1;
+	__m128i		k4;
+	__m128i		x0;
+	__m128i		x1;
+	__m128i		x2;
+	__m128i		x3;
+	unsigned char	buf[16];
+	int		i;
+
+	if (sum->rotate)
+		order = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+	else
+		order = _mm_set_epi64x(0x0f0e0d0c0b0a0908LL, 0x0706050403020100LL);
+	k1 = _mm_loadu_si128((const __m128i*)&sum->fold[0]);
+	x0 = _mm_xor_si128(CRC_LOAD(b), sum->rotate ? _mm_set_epi32((int)c, 0, 0, 0) : _mm_cvtsi32_si128((int)c));
+	b += 16;
+	n -= 16;
+	if (n >= 112)
+	{
+		k4 = _mm_loadu_si128((const __m128i*)&sum->fold[2]);
+		x1 = CRC_LOAD(b);
+		x2 = CRC_LOAD(b + 16);
+		x3 = CRC_LOAD(b + 32);
+		b += 48;
+		n -= 48;
+		do
+		{
+			x0 = CRC_FOLD(x0, k4, CRC_LOAD(b));
+			x1 = CRC_FOLD(x1, k4, CRC_LOAD(b + 16));
+			x2 = CRC_FOLD(x2, k4, CRC_LOAD(b + 32));
+			x3 = CRC_FOLD(x3, k4, CRC_LOAD(b + 48));
+			b += 64;
+			n -= 64;
+		} while (n >= 64);
+		x0 = CRC_FOLD(x0, k1, x1);
+		x0 = CRC_FOLD(x0, k1, x2);
+		x0 = CRC_FOLD(x0, k1, x3);
+	}
+	for (; n; b += 16, n -= 16)
+		x0 = CRC_FOLD(x0, k1, CRC_LOAD(b));
+	_mm_storeu_si128((__m128i*)buf, _mm_shuffle_epi8(x0, order));
+	c = 0;
+	if (sum->rotate)
+		for (i = 0; i < elementsof(buf); i++)
+			CRCROTATE(sum, c, buf[i]);
+	else
+		for (i = 0; i < elementsof(buf); i++)
+			CRC(sum, c, buf[i]);
+	return c;
+}
+
+/*
+ * set up the folding constants for polynomial and check crc_fold()
+ * against the table
+ */
+
+static void
+crc_clmul(Crc_t* sum, Crcnum_t polynomial)
+{
+	unsigned char	data[272];
+	Crcnum_t	c;
+	int		i;
+	int		n;
+
+	if (!sum->rotate)
+		polynomial = crc_reflect(polynomial);
+	for (i = 0; i < 2; i++)
+	{
+		n = i ? 512 : 128;
+		if (sum->rotate)
+		{
+			sum->fold[2*i] = crc_xpow(n, polynomial);
+			sum->fold[2*i+1] = crc_xpow(n + 64, polynomial);
+		}
+		else
+		{
+			sum->fold[2*i] = (uint64_t)crc_reflect(crc_xpow(n + 63, polynomial)) << 32;
+			sum->fold[2*i+1] = (uint64_t)crc_reflect(crc_xpow(n - 1, polynomial)) << 32;
+		}
+	}
+	c = 0x9e3779b9;
+	for (i = 0; i < elementsof(data); i++)
+	{
+		data[i] = i * 151 + 7;
+		if (sum->rotate)
+			CRCROTATE(sum, c, data[i]);
+		else
+			CRC(sum, c, data[i]);
+	}
+	sum->clmul = crc_fold(sum, 0x9e3779b9, data, elementsof(data)) == c;
+}
+
+#endif
+
 static Sum_t*
 crc_open(const Method_t* method, const char* name)
 {
@@ -140,6 +286,7 @@ crc_open(const Method_t* method, const char* name)
 
 		/* Optimized codepath for POSIX cksum to save startup time */
 		sum->tab=posix_cksum_tab;
+		polynomial = 0x04c11db7;
 	}
 	else
 	{
@@ -188,6 +335,7 @@ crc_open(const Method_t* method, const char* name)
 			}
 			sum->tabdata[i] = t;
 		}
+		sum->tab=sum->tabdata;
 	}
 	else
 	{
@@ -202,6 +350,10 @@ crc_open(const Method_t* method, const char* name)
 		sum->tab=sum->tabdata;
 	}
 	}
+#if _sum_x86
+	if (sum && (sumcpu() & SUM_CPU_CLMUL))
+		crc_clmul(sum, polynomial);
+#endif
 
 	return (Sum_t*)sum;
 }
@@ -239,6 +391,15 @@ crc_block(Sum_t* p, const void* s, size_t n)
 	register const unsigned char*	e = b + n;
 	unsigned short i;
 
+#if _sum_x86
+	if (sum->clmul && n >= CRC_FOLD_MIN)
+	{
+		c = crc_fold(sum, c, b, n & ~(size_t)15);
+		b += n & ~(size_t)15;
+		n &= 15;
+	}
+#endif
+
 	sum_prefetch(b);
 
 	if (sum->rotate)
@@ -296,6 +457,13 @@ crc_block(Sum_t* p, const void* s, size_t n)
 	register unsigned char*	b = (unsigned char*)s;
 	register unsigned char*	e = b + n;
 
+#if _sum_x86
+	if (sum->clmul && n >= CRC_FOLD_MIN)
+	{
+		c = crc_fold(sum, c, b, n & ~(size_t)15);
+		b += n & ~(size_t)15;
+	}
+#endif
 	if (sum->rotate)
 		while (b < e)
 			CRCROTATE(sum, c, *b++);
@@ -203,6 +203,122 @@ sha1_transform(uint32_t state[5], const unsigned char buffer[64]) {
 	a = b = c = d = e = 0;
 }
 
+#if _sum_x86
+
+/*
+ * hash n 512-bit blocks with the x86 SHA extensions
+ */
+
+#define SHA1_NI_LOAD(m,i) \
+	m = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16 * (i))), mask);
+#define SHA1_NI_R(ea,eb,m,f) \
+	ea = _mm_sha1nexte_epu32(ea, m); \
+	eb = abcd; \
+	abcd = _mm_sha1rnds4_epu32(abcd, ea, f);
+#define SHA1_NI_W(m,next,prev,prev2) \
+	next = _mm_sha1msg2_epu32(next, m); \
+	prev = _mm_sha1msg1_epu32(prev, m); \
+	prev2 = _mm_xor_si128(prev2, m);
+
+static SUM_TARGET("sha,sse4.1") void
+sha1_ni(uint32_t state[5], const unsigned char* data, size_t n)
+{
+	const __m128i	mask = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+	__m128i		abcd, abcd_save, e0, e0_save, e1;
+	__m128i		m0, m1, m2, m3;
+
+	abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1B);
+	e0 = _mm_set_epi32(state[4], 0, 0, 0);
+	for (; n; n--, data += 64)
+	{
+		abcd_save = abcd;
+		e0_save = e0;
+		SHA1_NI_LOAD(m0, 0)
+		e0 = _mm_add_epi32(e0, m0);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+		SHA1_NI_LOAD(m1, 1)
+		SHA1_NI_R(e1, e0, m1, 0)
+		m0 = _mm_sha1msg1_epu32(m0, m1);
+		SHA1_NI_LOAD(m2, 2)
+		SHA1_NI_R(e0, e1, m2, 0)
+		m1 = _mm_sha1msg1_epu32(m1, m2);
+		m0 = _mm_xor_si128(m0, m2);
+		SHA1_NI_LOAD(m3, 3)
+		SHA1_NI_R(e1, e0, m3, 0)
+		SHA1_NI_W(m3, m0, m2, m1)
+		SHA1_NI_R(e0, e1, m0, 0)
+		SHA1_NI_W(m0, m1, m3, m2)
+		SHA1_NI_R(e1, e0, m1, 1)
+		SHA1_NI_W(m1, m2, m0, m3)
+		SHA1_NI_R(e0, e1, m2, 1)
+		SHA1_NI_W(m2, m3, m1, m0)
+		SHA1_NI_R(e1, e0, m3, 1)
+		SHA1_NI_W(m3, m0, m2, m1)
+		SHA1_NI_R(e0, e1, m0, 1)
+		SHA1_NI_W(m0, m1, m3, m2)
+		SHA1_NI_R(e1, e0, m1, 1)
+		SHA1_NI_W(m1, m2, m0, m3)
+		SHA1_NI_R(e0, e1, m2, 2)
+		SHA1_NI_W(m2, m3, m1, m0)
+		SHA1_NI_R(e1, e0, m3, 2)
+		SHA1_NI_W(m3, m0, m2, m1)
+		SHA1_NI_R(e0, e1, m0, 2)
+		SHA1_NI_W(m0, m1, m3, m2)
+		SHA1_NI_R(e1, e0, m1, 2)
+		SHA1_NI_W(m1, m2, m0, m3)
+		SHA1_NI_R(e0, e1, m2, 2)
+		SHA1_NI_W(m2, m3, m1, m0)
+		SHA1_NI_R(e1, e0, m3, 3)
+		SHA1_NI_W(m3, m0, m2, m1)
+		SHA1_NI_R(e0, e1, m0, 3)
+		SHA1_NI_W(m0, m1, m3, m2)
+		SHA1_NI_R(e1, e0, m1, 3)
+		m2 = _mm_sha1msg2_epu32(m2, m1);
+		m3 = _mm_xor_si128(m3, m1);
+		SHA1_NI_R(e0, e1, m2, 3)
+		m3 = _mm_sha1msg2_epu32(m3, m2);
+		SHA1_NI_R(e1, e0, m3, 3)
+		e0 = _mm_sha1nexte_epu32(e0, e0_save);
+		abcd = _mm_add_epi32(abcd, abcd_save);
+	}
+	_mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1B));
+	state[4] = _mm_extract_epi32(e0, 3);
+}
+
+/*
+ * check sha1_ni() against sha1_transform() once
+ */
+
+static int
+sha1_accel(void)
+{
+	static int	accel = -1;
+	uint32_t	a[5];
+	uint32_t	b[5];
+	unsigned char	data[128];
+	int		i;
+
+	if (accel < 0)
+	{
+		accel = 0;
+		if (sumcpu() & SUM_CPU_SHA)
+		{
+			for (i = 0; i < elementsof(data); i++)
+				data[i] = i * 151 + 7;
+			for (i = 0; i < elementsof(a); i++)
+				a[i] = b[i] = 0x9e3779b9 * (i + 1);
+			sha1_transform(a, data);
+			sha1_transform(a, data + 64);
+			sha1_ni(b, data, 2);
+			accel = !memcmp(a, b, sizeof(a));
+		}
+	}
+	return accel;
+}
+
+#endif
+
 static int
 sha1_block(register Sum_t* p, const void* s, size_t len)
 {
@@ -217,9 +333,18 @@ sha1_block(register Sum_t* p, const void* s, size_t len)
 		j = (j >> 3) & 63;
 		if ((j + len) > 63) {
 			(void)memcpy(&sha->buffer[j], data, (i = 64 - j));
-			sha1_transform(sha->state, sha->buffer);
-			for ( ; i + 63 < len; i += 64)
-				sha1_transform(sha->state, &data[i]);
+#if _sum_x86
+			if (sha1_accel()) {
+				sha1_ni(sha->state, sha->buffer, 1);
+				sha1_ni(sha->state, &data[i], (len - i) / 64);
+				i += (len - i) & ~63;
+			} else
+#endif
+			{
+				sha1_transform(sha->state, sha->buffer);
+				for ( ; i + 63 < len; i += 64)
+					sha1_transform(sha->state, &data[i]);
+			}
 			j = 0;
 		} else {
 			i = 0;
@@ -626,6 +626,124 @@ static void SHA256_Transform(SHA256_CTX* sha, const sha2_word32* data) {
 
 #endif /* SHA2_UNROLL_TRANSFORM */
 
+#if _sum_x86
+
+/*
+ * hash n 512-bit blocks with the x86 SHA extensions
+ */
+
+#define SHA256_NI_LOAD(m,i) \
+	m = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16 * (i))), mask);
+#define SHA256_NI_R(m,i) \
+	msg = _mm_add_epi32(m, _mm_loadu_si128((const __m128i*)&K256[4 * (i)])); \
+	cdgh = _mm_sha256rnds2_epu32(cdgh, abef, msg); \
+	abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(msg, 0x0E));
+#define SHA256_NI_W2(m,next,prev) \
+	next = _mm_sha256msg2_epu32(_mm_add_epi32(next, _mm_alignr_epi8(m, prev, 4)), m);
+#define SHA256_NI_W1(m,prev) \
+	prev = _mm_sha256msg1_epu32(prev, m);
+
+static SUM_TARGET("sha,sse4.1") void
+sha256_ni(sha2_word32 state[8], const sha2_byte* data, size_t n)
+{
+	const __m128i	mask = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+	__m128i		abef, abef_save, cdgh, cdgh_save, msg, t;
+	__m128i		m0, m1, m2, m3;
+
+	t = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xB1);
+	cdgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1B);
+	abef = _mm_alignr_epi8(t, cdgh, 8);
+	cdgh = _mm_blend_epi16(cdgh, t, 0xF0);
+	for (; n; n--, data += SHA256_BLOCK_LENGTH)
+	{
+		abef_save = abef;
+		cdgh_save = cdgh;
+		SHA256_NI_LOAD(m0, 0)
+		SHA256_NI_R(m0, 0)
+		SHA256_NI_LOAD(m1, 1)
+		SHA256_NI_R(m1, 1)
+		SHA256_NI_W1(m1, m0)
+		SHA256_NI_LOAD(m2, 2)
+		SHA256_NI_R(m2, 2)
+		SHA256_NI_W1(m2, m1)
+		SHA256_NI_LOAD(m3, 3)
+		SHA256_NI_R(m3, 3)
+		SHA256_NI_W2(m3, m0, m2)
+		SHA256_NI_W1(m3, m2)
+		SHA256_NI_R(m0, 4)
+		SHA256_NI_W2(m0, m1, m3)
+		SHA256_NI_W1(m0, m3)
+		SHA256_NI_R(m1, 5)
+		SHA256_NI_W2(m1, m2, m0)
+		SHA256_NI_W1(m1, m0)
+		SHA256_NI_R(m2, 6)
+		SHA256_NI_W2(m2, m3, m1)
+		SHA256_NI_W1(m2, m1)
+		SHA256_NI_R(m3, 7)
+		SHA256_NI_W2(m3, m0, m2)
+		SHA256_NI_W1(m3, m2)
+		SHA256_NI_R(m0, 8)
+		SHA256_NI_W2(m0, m1, m3)
+		SHA256_NI_W1(m0, m3)
+		SHA256_NI_R(m1, 9)
+		SHA256_NI_W2(m1, m2, m0)
+		SHA256_NI_W1(m1, m0)
+		SHA256_NI_R(m2, 10)
+		SHA256_NI_W2(m2, m3, m1)
+		SHA256_NI_W1(m2, m1)
+		SHA256_NI_R(m3, 11)
+		SHA256_NI_W2(m3, m0, m2)
+		SHA256_NI_W1(m3, m2)
+		SHA256_NI_R(m0, 12)
+		SHA256_NI_W2(m0, m1, m3)
+		SHA256_NI_W1(m0, m3)
+		SHA256_NI_R(m1, 13)
+		SHA256_NI_W2(m1, m2, m0)
+		SHA256_NI_R(m2, 14)
+		SHA256_NI_W2(m2, m3, m1)
+		SHA256_NI_R(m3, 15)
+		abef = _mm_add_epi32(abef, abef_save);
+		cdgh = _mm_add_epi32(cdgh, cdgh_save);
+	}
+	t = _mm_shuffle_epi32(abef, 0x1B);
+	cdgh = _mm_shuffle_epi32(cdgh, 0xB1);
+	_mm_storeu_si128((__m128i*)&state[0], _mm_blend_epi16(t, cdgh, 0xF0));
+	_mm_storeu_si128((__m128i*)&state[4], _mm_alignr_epi8(cdgh, t, 8));
+}
+
+/*
+ * check sha256_ni() against SHA256_Transform() once
+ */
+
+static int
+sha256_accel(void)
+{
+	static int	accel = -1;
+	Sha256_t	a;
+	Sha256_t	b;
+	sha2_byte	data[2 * SHA256_BLOCK_LENGTH];
+	int		i;
+
+	if (accel < 0)
+	{
+		accel = 0;
+		if (sumcpu() & SUM_CPU_SHA)
+		{
+			for (i = 0; i < elementsof(data); i++)
+				data[i] = i * 151 + 7;
+			for (i = 0; i < elementsof(a.state); i++)
+				a.state[i] = b.state[i] = 0x9e3779b9 * (i + 1);
+			SHA256_Transform(&a, (sha2_word32*)data);
+			SHA256_Transform(&a, (sha2_word32*)(data + SHA256_BLOCK_LENGTH));
+			sha256_ni(b.state, data, 2);
+			accel = !memcmp(a.state, b.state, sizeof(a.state));
+		}
+	}
+	return accel;
+}
+
+#endif
+
 static int
 sha256_block(register Sum_t* p, const void* s, size_t len)
 {
@@ -656,6 +774,17 @@ sha256_block(register Sum_t* p, const void* s, size_t len)
 			return 0;
 		}
 	}
+#if _sum_x86
+	if (len >= SHA256_BLOCK_LENGTH && sha256_accel()) {
+		/* Process all complete blocks at once */
+		size_t	n = len & ~(size_t)(SHA256_BLOCK_LENGTH - 1);
+
+		sha256_ni(sha->state, data, n / SHA256_BLOCK_LENGTH);
+		sha->bitcount += (sha2_word64)n << 3;
+		len -= n;
+		data += n;
+	}
+#endif
 	while (len >= SHA256_BLOCK_LENGTH) {
 		/* Process as many complete blocks as we can */
 		SHA256_Transform(sha, (sha2_word32*)data);
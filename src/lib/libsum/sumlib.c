@@ -146,6 +146,50 @@ long_data(Sum_t* p, Sumdata_t* data)
 
 #include "FEATURE/sum"
 
+/*
+ * instruction set extensions for the block functions, detected at runtime;
+ * each method verifies its accelerated kernel against the portable one on
+ * first use and falls back to the portable code if the results differ
+ */
+
+#define SUM_CPU_SHA	(1<<0)		/* SHA-1 and SHA-256 instructions */
+#define SUM_CPU_CLMUL	(1<<1)		/* carry-less multiply		*/
+#define SUM_CPU_INIT	(1<<2)		/* cpu already probed		*/
+
+#if _sum_x86
+
+#include <immintrin.h>
+#include <cpuid.h>
+
+#define SUM_TARGET(x)	__attribute__((target(x)))
+
+static unsigned int
+sumcpu(void)
+{
+	static unsigned int	cpu;
+	unsigned int		a, b, c, d;
+
+	if (!cpu)
+	{
+		cpu = SUM_CPU_INIT;
+		if (__get_cpuid(1, &a, &b, &c, &d) && (c & (1<<9)) && (c & (1<<19)))
+		{
+			/* SSSE3 and SSE4.1 are needed by both kernels */
+			if (c & (1<<1))
+				cpu |= SUM_CPU_CLMUL;
+			if (__get_cpuid_max(0, NiL) >= 7)
+			{
+				__cpuid_count(7, 0, a, b, c, d);
+				if (b & (1<<29))
+					cpu |= SUM_CPU_SHA;
+			}
+		}
+	}
+	return cpu;
+}
+
+#endif
+
 #include "sum-att.c"
 #include "sum-ast4.c"
 #include "sum-bsd.c"